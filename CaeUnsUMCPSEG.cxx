@@ -23,9 +23,13 @@
 #include "CaePlugin.h"
 #include "CaeUnsGridModel.h"
 #include "CaeUnsUMCPSEG.h"
+#include "NlistBinary.h"
+#include "NlistFormat.h"
+#include "NlistLog.h"
 
 #include<algorithm>
 #include<cassert>
+#include<cmath>
 #include<string>
 
 
@@ -37,13 +41,186 @@
 
 
 const char *CreateLog   = "CreateLog";
+const char *OutputBufferSize = "OutputBufferSize";
+const char *ThreadCount = "ThreadCount";
+const char *NeighborOrder = "NeighborOrder";
+const char *MapOutputFile = "MapOutputFile";
+const char *Compression = "Compression";
+const char *ProgressSteps = "ProgressSteps";
+const char *ProgressInterval = "ProgressInterval";
+const char *CreateStats = "CreateStats";
+const char *LogFormat   = "LogFormat";
+const char *LogLevel    = "LogLevel";
+const char *LogMaterials = "LogMaterials";
+const char *LogZones    = "LogZones";
+const char *LogNodes    = "LogNodes";
+
+// Max chars of one NODES line 1, FACES line or GEOMETRY line
+enum { NlistLineMaxChars = 512 };
+
+// Max chars of one NODES line 1
+enum { NodeLineMaxChars = 128 };
+
+// Max chars per neighbor of a NODES line 2
+enum { NlistNborMaxChars = 7 + NlistFormat::MaxIntChars };
+
+// NODES are formatted in chunks of NodesPerChunk nodes. Each thread is given
+// about ChunksPerThread chunks per batch.
+enum { NodesPerChunk = 2048 };
+enum { ChunksPerThread = 2 };
+
+// Streamed edges are classified in chunks of EdgesPerChunk edges
+enum { EdgesPerChunk = 16384 };
+
+// FACES are formatted in chunks of ElemsPerChunk elements
+enum { ElemsPerChunk = 4096 };
+
+// Chars in a FACES line when all indices fit in 7 digits
+enum { FaceLineChars = 4 * 7 + 1 };
+
+// formatFaceRun() converts the indices of FaceBlockElems elements at a time
+enum { FaceBlockElems = 256 };
+
+
+// Returns the codec of a compressed file extension (".gz" or ".zst") of
+// fileName or CodecNone.
+static StreamCompressor::Codec
+extCodec(const char *fileName)
+{
+    const size_t len = strlen(fileName);
+    if (len >= 3 && 0 == strcmp(fileName + len - 3, ".gz")) {
+        return StreamCompressor::CodecGzip;
+    }
+    if (len >= 4 && 0 == strcmp(fileName + len - 4, ".zst")) {
+        return StreamCompressor::CodecZstd;
+    }
+    return StreamCompressor::CodecNone;
+}
+
+
+// Returns fileName without its compressed file extension (".gz" or ".zst").
+// The log and stats files are named after it and are never compressed.
+static std::string
+sidecarBase(const char *fileName)
+{
+    std::string ret(fileName);
+    switch (extCodec(fileName)) {
+    case StreamCompressor::CodecGzip:   ret.resize(ret.size() - 3); break;
+    case StreamCompressor::CodecZstd:   ret.resize(ret.size() - 4); break;
+    default:                            break;
+    }
+    return ret;
+}
+
+
+// Returns a value that increases monotonically with the counter-clockwise
+// angle of (dx, dy) from the +x axis in [0, 4). Cheaper than atan2().
+static double
+pseudoAngle(const double dx, const double dy)
+{
+    const double sum = std::fabs(dx) + std::fabs(dy);
+    if (0.0 == sum) {
+        return 0.0;
+    }
+    const double p = dy / sum;
+    return (dx < 0.0) ? (2.0 - p) : ((dy < 0.0) ? (4.0 + p) : p);
+}
+
 
+// Returns the number of chars written by NlistFormat::intField(p, val, 7)
+static size_t
+int7Chars(const PWP_UINT32 val)
+{
+    size_t ret = 7;
+    for (PWP_UINT32 lim = 10000000; val >= lim && ret < 10; lim *= 10) {
+        ++ret;
+    }
+    return ret;
+}
 
-static char
-matIdChar(const MaterialId matId)
+
+// Returns the number of chars written by formatFace(p, n0, n1, n2)
+static size_t
+faceLineChars(const PWP_UINT32 n0, const PWP_UINT32 n1, const PWP_UINT32 n2)
 {
-    static const char idMap[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    return (matId < 0 || matId > 35) ? '?' : idMap[matId];
+    return int7Chars(n0 + 1) + int7Chars(n1 + 1) + 2 * int7Chars(n2 + 1) + 1;
+}
+
+
+// Writes one FACES line. n0, n1 and n2 are 1-based. If IsFixedWidth, all
+// indices must fit in 7 digits.
+template<bool IsFixedWidth>
+static char*
+faceLine(char *p, const PWP_UINT32 n0, const PWP_UINT32 n1,
+    const PWP_UINT32 n2)
+{
+    //         1         2         3         4
+    //1234567890123456789012345678901234567890
+    //   6159   6173   6160   6160
+    // ...snip...
+    //   6175   6109   6174   6174
+    //
+    // yes, n2 is repeated (collapsed quad?)
+    //
+    // Same as writef("%7d%7d%7d%7d\n", ...)
+    if (IsFixedWidth) {
+        p = NlistFormat::fixedUIntField(p, n0, 7);
+        p = NlistFormat::fixedUIntField(p, n1, 7);
+        p = NlistFormat::fixedUIntField(p, n2, 7);
+        p = NlistFormat::fixedUIntField(p, n2, 7);
+    }
+    else {
+        p = NlistFormat::intField(p, int(n0), 7);
+        p = NlistFormat::intField(p, int(n1), 7);
+        p = NlistFormat::intField(p, int(n2), 7);
+        p = NlistFormat::intField(p, int(n2), 7);
+    }
+    *p++ = '\n';
+    return p;
+}
+
+
+// Writes the FACES lines of cnt consecutive elements of type Type (tri or
+// quad). verts are their ElemTable records (4 per element). Quads are
+// written as two tris. Each block of elements is converted to 1-based
+// indices in a separate loop the compiler can vectorize.
+template<PWGM_ENUM_ELEMTYPE Type, bool IsFixedWidth>
+static char*
+formatFaceRun(char *p, const PWP_UINT32 *verts, const PWP_UINT32 cnt)
+{
+    PWP_UINT32 ndx[FaceBlockElems * 4];
+    for (PWP_UINT32 b = 0; b < cnt; b += FaceBlockElems) {
+        const PWP_UINT32 n = std::min(PWP_UINT32(FaceBlockElems), cnt - b) * 4;
+        const PWP_UINT32 *v = verts + size_t(b) * 4;
+        // The unused 4th index of a tri wraps to 0
+        for (PWP_UINT32 ii = 0; ii < n; ++ii) {
+            ndx[ii] = v[ii] + 1;
+        }
+        for (PWP_UINT32 ii = 0; ii < n; ii += 4) {
+            p = faceLine<IsFixedWidth>(p, ndx[ii], ndx[ii + 1], ndx[ii + 2]);
+            if (PWGM_ELEMTYPE_QUAD == Type) {
+                p = faceLine<IsFixedWidth>(p, ndx[ii], ndx[ii + 2],
+                    ndx[ii + 3]);
+            }
+        }
+    }
+    return p;
+}
+
+
+// Calls the formatFaceRun() specialization for isQuad and isFixedWidth
+static char*
+formatFaceRun(char *p, const PWP_UINT32 *verts, const PWP_UINT32 cnt,
+    const bool isQuad, const bool isFixedWidth)
+{
+    if (isQuad) {
+        return isFixedWidth ?
+            formatFaceRun<PWGM_ELEMTYPE_QUAD, true>(p, verts, cnt) :
+            formatFaceRun<PWGM_ELEMTYPE_QUAD, false>(p, verts, cnt);
+    }
+    return isFixedWidth ?
+        formatFaceRun<PWGM_ELEMTYPE_TRI, true>(p, verts, cnt) :
+        formatFaceRun<PWGM_ELEMTYPE_TRI, false>(p, verts, cnt);
 }
 
 
@@ -70,55 +247,193 @@ StdStringCache  CaeUnsUMCPSEG::typeNames_;
 CaeUnsUMCPSEG::CaeUnsUMCPSEG(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
         const CAEP_WRITEINFO *pWriteInfo) :
     CaeUnsPlugin(pRti, model, pWriteInfo),
-    nodeInfo_(),
-    geomEdges_(),
+    arena_(),
+    nodeInfo_(arena_),
+    nodeNbors_(arena_),
+    elemBlk_(),
+    elemBlkChecked_(),
+    elemBlkOk_(false),
+    edges_(),
+    edgeRecs_(),
+    serialStream_(false),
+    streamGeomEdges_(),
+    coords_(arena_),
+    elems_(arena_),
+    geomEdges_(arena_),
+    streamCnts_(),
+    zip_(),
+    out_(),
+    numThreads_(1),
+    pool_(),
+    nborOrder_(NborOrderStream),
+    progress_(),
+    useMap_(true),
+    map_(),
+    faceChunkOffsets_(arena_),
     log_(),
-    curBlkId_(PWP_UINT32_UNDEF),
-    curBlkCond_(),
-    curDomId_(PWP_UINT32_UNDEF),
-    curDomCond_()
+    logOut_(),
+    binaryLog_(false),
+    logFilter_(),
+    logNodeCnt_(0),
+    logEdgeCnt_(0),
+    stats_(),
+    createStats_(false),
+    writeOk_(false),
+    blkConds_(arena_),
+    domConds_(arena_)
 {
 }
 
 
 CaeUnsUMCPSEG::~CaeUnsUMCPSEG()
 {
+    // arena_ is destroyed after the containers that point into it
 }
 
 
 bool
 CaeUnsUMCPSEG::beginExport()
 {
-    setProgressMajorSteps(3);
+    setProgressMajorSteps(5);
+    stats_.reset();
+    stats_.start(ExportStats::PhaseExport);
+    writeOk_ = false;
+    createStats_ = false;
+    model_.getAttribute(CreateStats, createStats_, createStats_);
+
+    // Compression selects the codec. Auto uses the codec of a .gz or .zst
+    // export file and no compression for any other file.
+    const char *compression = "Auto";
+    model_.getAttribute(Compression, compression, compression);
+    StreamCompressor::Codec codec = StreamCompressor::CodecNone;
+    if (0 == strcmp(compression, "gzip")) {
+        codec = StreamCompressor::CodecGzip;
+    }
+    else if (0 == strcmp(compression, "zstd")) {
+        codec = StreamCompressor::CodecZstd;
+    }
+    else if (0 != strcmp(compression, "None")) {
+        codec = extCodec(writeInfo_.fileDest);
+    }
+    if (!StreamCompressor::isAvailable(codec)) {
+        sendErrorMsg("The Compression codec is not supported by this build");
+        return false;
+    }
+    if (StreamCompressor::CodecNone != codec && !zip_.start(rtFile_, codec)) {
+        sendErrorMsg("Could not start the compressor");
+        return false;
+    }
+
+    PWP_UINT bufMB = 8;
+    model_.getAttribute(OutputBufferSize, bufMB, bufMB);
+    out_.attach(rtFile_, size_t(bufMB) * 1024 * 1024,
+        (zip_.isStarted() ? &zip_ : 0));
+
+    PWP_UINT numThreads = 0;
+    model_.getAttribute(ThreadCount, numThreads, numThreads);
+    if (0 == numThreads) {
+        numThreads = PWP_UINT(std::thread::hardware_concurrency());
+    }
+    numThreads_ = std::max(PWP_UINT32(1), PWP_UINT32(numThreads));
+    pool_.start(numThreads_);
+
+    PWP_UINT progSteps = 100;
+    model_.getAttribute(ProgressSteps, progSteps, progSteps);
+    PWP_UINT progInterval = 250;
+    model_.getAttribute(ProgressInterval, progInterval, progInterval);
+    progress_.setLimits(PWP_UINT32(progSteps), progInterval / 1000.0);
+
+    useMap_ = true;
+    model_.getAttribute(MapOutputFile, useMap_, useMap_);
+    // Compressed output cannot be mapped
+    useMap_ = useMap_ && !zip_.isStarted();
+
+    const char *nborOrder = "Stream";
+    model_.getAttribute(NeighborOrder, nborOrder, nborOrder);
+    if (0 == strcmp(nborOrder, "Index")) {
+        nborOrder_ = NborOrderIndex;
+    }
+    else if (0 == strcmp(nborOrder, "Angle")) {
+        nborOrder_ = NborOrderAngle;
+    }
+    else {
+        nborOrder_ = NborOrderStream;
+    }
 
     bool createLog = false;
     model_.getAttribute(CreateLog, createLog, createLog);
+    const char *logFormat = "Text";
+    model_.getAttribute(LogFormat, logFormat, logFormat);
+    binaryLog_ = (0 == strcmp(logFormat, "Binary"));
+    const char *logLevel = "Full";
+    model_.getAttribute(LogLevel, logLevel, logLevel);
+    if (0 == strcmp(logLevel, "Summary")) {
+        logFilter_.setLevel(LogFilter::LevelSummary);
+    }
+    else if (0 == strcmp(logLevel, "Conflicts")) {
+        logFilter_.setLevel(LogFilter::LevelConflicts);
+    }
+    else if (0 == strcmp(logLevel, "Boundary")) {
+        logFilter_.setLevel(LogFilter::LevelBoundary);
+    }
+    else {
+        logFilter_.setLevel(LogFilter::LevelFull);
+    }
+    const char *logMats = "";
+    model_.getAttribute(LogMaterials, logMats, logMats);
+    if (!logFilter_.setMaterials(logMats)) {
+        sendWarningMsg("Invalid LogMaterials. Logging all materials.");
+    }
+    const char *logZones = "";
+    model_.getAttribute(LogZones, logZones, logZones);
+    if (!logFilter_.setZones(logZones)) {
+        sendWarningMsg("Invalid LogZones. Logging all zones.");
+    }
+    const char *logNodes = "";
+    model_.getAttribute(LogNodes, logNodes, logNodes);
+    if (!logFilter_.setNodes(logNodes)) {
+        sendWarningMsg("Invalid LogNodes. Logging all nodes.");
+    }
+    logNodeCnt_ = 0;
+    logEdgeCnt_ = 0;
     if (createLog) {
-        std::string logFile(writeInfo_.fileDest);
-        logFile += ".log";
-        log_.open(logFile, pwpWrite | pwpAscii);
+        std::string logFile(sidecarBase(writeInfo_.fileDest));
+        logFile += (binaryLog_ ? ".log.bin" : ".log");
+        if (log_.open(logFile, pwpWrite |
+                (binaryLog_ ? pwpBinary : pwpAscii))) {
+            // The log shares the out_ buffer size. Node and edge lines are
+            // formatted straight into it.
+            logOut_.attach(log_, size_t(bufMB) * 1024 * 1024);
+        }
+        else {
+            sendWarningMsg("Could not open the log file");
+        }
     }
 
     if (log_.isOpen()) {
-        log_.write("# To process node and edge data in this log file, source\n"
-                   "# this log into a script that defines two procs that are\n"
-                   "# compatable with the following signatures:\n");
-        log_.write("\n");
-        log_.write("# proc node { nodeId pt matId matConflict isBndry zoneId "
-                                 "zoneConflict nborIds } {\n");
-        log_.write("#   your NODE code here!\n");
-        log_.write("# }\n");
-        log_.write("\n");
-        log_.write("# proc edge { ndx0 pt0 ndx1 pt1 } {\n");
-        log_.write("#   your GEOM code here!\n");
-        log_.write("# }\n");
-        log_.write("\n");
-        log_.write("# source {your.nlist.log}\n");
-        log_.write("\n");
-
-        log_.writef("set UndefinedMatId %d\n", int(MatUndefined));
-        log_.writef("set UndefinedZoneId %d\n", int(ZoneUndefined));
-        log_.write("\n");
+        if (binaryLog_) {
+            logOut_.commit(NlistLog::putFileHeader(logOut_.reserve(
+                NlistLog::FileHeaderBytes)));
+        }
+        logText("# To process node and edge data in this log file, source\n"
+                "# this log into a script that defines two procs that are\n"
+                "# compatable with the following signatures:\n"
+                "\n"
+                "# proc node { nodeId pt matId matConflict isBndry zoneId "
+                    "zoneConflict nborIds } {\n"
+                "#   your NODE code here!\n"
+                "# }\n"
+                "\n"
+                "# proc edge { ndx0 pt0 ndx1 pt1 } {\n"
+                "#   your GEOM code here!\n"
+                "# }\n"
+                "\n"
+                "# source {your.nlist.log}\n"
+                "\n");
+        logWritef("set UndefinedMatId %d\nset UndefinedZoneId %d\n\n",
+            int(MatUndefined), int(ZoneUndefined));
+        logWritef("# log: level %s materials {%s} zones {%s} nodes {%s}\n",
+            logLevel, logMats, logZones, logNodes);
     }
     return true;
 }
@@ -127,113 +442,505 @@ CaeUnsUMCPSEG::beginExport()
 PWP_BOOL
 CaeUnsUMCPSEG::write()
 {
-    return init() && writeHeader() && writeNodes() && writeFaces() &&
-        writeGeometry();
+    typedef ExportStats Stats;
+    stats_.set(Stats::CountNodes, model_.vertexCount());
+    stats_.set(Stats::CountElements, model_.elementCount());
+    bool ret = runPhase(Stats::PhaseInit, &CaeUnsUMCPSEG::init) &&
+        runPhase(Stats::PhaseVertices, &CaeUnsUMCPSEG::loadVertices) &&
+        runPhase(Stats::PhaseSortNbors, &CaeUnsUMCPSEG::sortNbors) &&
+        runPhase(Stats::PhaseElements, &CaeUnsUMCPSEG::loadElements);
+    if (PWP_ENCODING_BINARY == writeInfo_.encoding) {
+        ret = ret && runPhase(Stats::PhaseBinary, &CaeUnsUMCPSEG::writeBinary);
+    }
+    else {
+        ret = ret &&
+            runPhase(Stats::PhaseHeader, &CaeUnsUMCPSEG::writeHeader) &&
+            runPhase(Stats::PhaseNodes, &CaeUnsUMCPSEG::writeNodes) &&
+            runPhase(Stats::PhaseFaces, &CaeUnsUMCPSEG::writeFaces) &&
+            runPhase(Stats::PhaseGeometry, &CaeUnsUMCPSEG::writeGeometry);
+    }
+    stats_.add(Stats::CountBytesWritten, out_.bytesWritten());
+    writeOk_ = out_.detach() && ret;
+    return writeOk_;
 }
 
 
 bool
 CaeUnsUMCPSEG::endExport()
 {
+    stats_.stop(ExportStats::PhaseExport);
+    if (createStats_) {
+        stats_.setNborHistogram(nodeNbors_);
+        const std::string statsFile = sidecarBase(writeInfo_.fileDest) +
+            ".stats.json";
+        if (!stats_.write(statsFile, writeOk_)) {
+            sendWarningMsg("Could not write the .stats.json file");
+        }
+    }
+
+    // The per-export tables are in arena_. Drop the containers and free the
+    // arena blocks in one shot. The face stream arrays and the output buffer
+    // use the heap (see StreamUInt32Array1 and BufferCharArray1). The stream
+    // arrays are only left over if write() did not run to the end.
+    pool_.stop();
+    out_.detach();
+    StreamUInt32Array1().swap(elemBlk_);
+    StreamUInt8Array1().swap(elemBlkChecked_);
+    StreamEdgeArray1().swap(edges_);
+    EdgeRecArray1().swap(edgeRecs_);
+    StreamEdgeArray1().swap(streamGeomEdges_);
+    releaseArray(faceChunkOffsets_);
+    nodeInfo_.clear();
+    nodeNbors_.clear();
+    releaseArray(geomEdges_);
+    coords_.clear();
+    elems_.clear();
+    blkConds_.clear();
+    domConds_.clear();
+    MonotonicArena &arena = arena_;
+    if (log_.isOpen()) {
+        logWritef("# log: %lu nodes and %lu edges logged\n",
+            (unsigned long)logNodeCnt_, (unsigned long)logEdgeCnt_);
+        logWritef("# arena: %lu allocations, %.1f MB used, %.1f MB in %lu "
+            "blocks, %.1f MB peak\n", (unsigned long)arena.allocCount(),
+            arena.usedBytes() / 1048576.0, arena.blockBytes() / 1048576.0,
+            (unsigned long)arena.blockCount(), arena.peakBytes() / 1048576.0);
+        if (!logOut_.detach() || !log_.close()) {
+            sendWarningMsg("Could not write the log file");
+        }
+    }
+    arena.release();
     return true;
 }
 
 
+bool
+CaeUnsUMCPSEG::runPhase(const ExportStats::Phase phase,
+    bool (CaeUnsUMCPSEG::*func)())
+{
+    stats_.start(phase);
+    const bool ret = (this->*func)();
+    stats_.stop(phase);
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::beginThrottledStep(const PWP_UINT32 total)
+{
+    // The host only sees the coalesced increments of the total items
+    return progressBeginStep(progress_.begin(total));
+}
+
+
+bool
+CaeUnsUMCPSEG::throttledIncrement(const PWP_UINT32 cnt)
+{
+    // Marks cnt items done. Returns false if the export was aborted.
+    bool ret = true;
+    for (PWP_UINT32 ii = progress_.advance(cnt); ret && ii > 0; --ii) {
+        ret = progressIncrement();
+    }
+    return ret;
+}
+
+
 bool
 CaeUnsUMCPSEG::init()
+{
+    // All edges are known once streamEdges() returns. Fill nodeInfo_ and
+    // build the neighbor lists in one shot.
+    const bool ret = streamEdges();
+    if (ret) {
+        stats_.start(ExportStats::PhaseNodeTables);
+        buildNodeTables();
+        stats_.stop(ExportStats::PhaseNodeTables);
+    }
+    EdgeRecArray1().swap(edgeRecs_);
+    StreamEdgeArray1().swap(streamGeomEdges_);
+    StreamEdgeArray1().swap(edges_);
+    stats_.set(ExportStats::CountBlkCondUndefined,
+        blkConds_.undefinedCount());
+    stats_.set(ExportStats::CountDomCondUndefined,
+        domConds_.undefinedCount());
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::streamEdges()
 {
     const PWGM_ENUM_FACEORDER order = PWGM_FACEORDER_DONTCARE;
     // Stream the faces (in this case, 2D edges) of the grid and identify the
     // material id and zone id of each node and classify each edge as boundary
     // or interior. See comments for streamFace() for more details.
-    return model_.streamFaces(order, *this);
+    buildElemBlocks();
+    bool ret = buildCondTables() && model_.streamFaces(order, *this);
+    if (!ret && serialStream_ && !elemBlkOk_) {
+        // A serial stream stops at the first owner or neighbor element that
+        // is not in the block buildElemBlocks() expected. Its edges were
+        // classified with the wrong blocks, so look the blocks up and stream
+        // again.
+        // buildCondTables() resets the condition lookup counts.
+        ret = lookupElemBlocks() && buildCondTables() &&
+            model_.streamFaces(order, *this);
+    }
+    StreamUInt32Array1().swap(elemBlk_);
+    StreamUInt8Array1().swap(elemBlkChecked_);
+    return ret;
 }
 
 
 bool
-CaeUnsUMCPSEG::writeOneNode(const CaeUnsVertex &v, const NodeInfo &ptInfo)
+CaeUnsUMCPSEG::buildCondTables()
 {
-    // line 1
-    //         1         2         3         4         5         6
-    //123456789012345678901234567890123456789012345678901234567890
-    // 6.85000000000000D-01 3.14500000000000D+00    5  0 0  0 1
-    bool hadMatConflict = false;
-    bool hadZoneConflict = false;
-    const MaterialId matId = ptInfo.getMaterial(hadMatConflict);
-    const ZoneId zoneId = ptInfo.getZone(hadZoneConflict);
-    bool ret = rtFile_.writef("%21.14E%21.14E%5d %2d %c %2d%2d\n",
-        double(v.x()), double(v.y()), int(ptInfo.nborCount()), int(matId),
-        matIdChar(matId), int(ptInfo.isBndry() ? 1 : 0), int(zoneId));
-
-    // line 2
-    //         1         2         3         4         5
-    //12345678901234567890123456789012345678901234567890
-    //     59   5513     60   5538   5539   2262   2251
-    const UInt32Array1& nbors = ptInfo.nbors();
-    switch (nbors.size()) {
-    case 1: // INVALID
-        ret = false;
-        assert(ret);
-        break;
-    case 2:
-        ret = rtFile_.writef("%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1));
-        break;
-    case 3:
-        ret = rtFile_.writef("%7d%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1), (int)(nbors.at(2) + 1));
-        break;
-    case 4:
-        ret = rtFile_.writef("%7d%7d%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1), (int)(nbors.at(2) + 1),
-            (int)(nbors.at(3) + 1));
-        break;
-    case 5:
-        ret = rtFile_.writef("%7d%7d%7d%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1), (int)(nbors.at(2) + 1),
-            (int)(nbors.at(3) + 1), (int)(nbors.at(4) + 1));
-        break;
-    case 6:
-        ret = rtFile_.writef("%7d%7d%7d%7d%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1), (int)(nbors.at(2) + 1),
-            (int)(nbors.at(3) + 1), (int)(nbors.at(4) + 1),
-            (int)(nbors.at(5) + 1));
-        break;
-    case 7:
-        ret = rtFile_.writef("%7d%7d%7d%7d%7d%7d%7d\n", (int)(nbors.at(0) + 1),
-            (int)(nbors.at(1) + 1), (int)(nbors.at(2) + 1),
-            (int)(nbors.at(3) + 1), (int)(nbors.at(4) + 1),
-            (int)(nbors.at(5) + 1), (int)(nbors.at(6) + 1));
-        break;
-    default: {
-        // > 7 neighbors, use slower loop!
-        UInt32Array1::const_iterator nit = ptInfo.nbors().begin();
-        for (; ret && ptInfo.nbors().end() != nit; ++nit) {
-            ret = rtFile_.writef("%7d", (int)((*nit) + 1));
+    // Resolve every block VC and domain BC to its material and zone id once.
+    // Every material id a node can get passes through here, so this is where
+    // ids that do not fit nodeInfo_ are rejected.
+    bool ret = true;
+    MaterialId matId;
+    ZoneId zoneId;
+    PWGM_CONDDATA cd;
+    blkConds_.resize(model_.blockCount());
+    for (CaeUnsBlock blk(model_); ret && blk.isValid(); ++blk) {
+        if (blk.condition(cd)) {
+            getMatAndZone(cd, matId, zoneId);
+            ret = NodeTable::isNarrowMaterial(matId);
+            blkConds_.set(blk.index(), matId, zoneId);
+        }
+    }
+    domConds_.resize(model_.patchCount());
+    for (CaeUnsPatch dom(model_); ret && dom.isValid(); ++dom) {
+        if (dom.condition(cd)) {
+            getMatAndZone(cd, matId, zoneId);
+            ret = NodeTable::isNarrowMaterial(matId);
+            domConds_.set(dom.index(), matId, zoneId);
         }
-        ret = ret && rtFile_.write("\n");
-        break; }
     }
+    if (!ret) {
+        sendErrorMsg("buildCondTables: Condition type id out of range",
+            cd.tid);
+    }
+    return ret;
+}
+
+
+void
+CaeUnsUMCPSEG::buildElemBlocks()
+{
+    // ASSUMES the model element indices are the block elements concatenated
+    // in block order, which is how the grid model enumerates them. Fill
+    // elemBlk_ from the block element counts so getNborBlk() is an array
+    // lookup without a grid model call per edge. streamFace() checks every
+    // owner element against elemBlk_ and checkNborBlk() every neighbor
+    // element. Either clears elemBlkOk_ on a mismatch.
+    const PWP_UINT32 elemCnt = model_.elementCount();
+    elemBlk_.resize(elemCnt);
+    elemBlkChecked_.assign(elemCnt, 0);
+    PWP_UINT32 first = 0;
+    CaeUnsBlock blk(model_);
+    for (; blk.isValid(); ++blk) {
+        const PWP_UINT32 cnt = blk.elementCount();
+        if (cnt > elemCnt - first) {
+            break;
+        }
+        std::fill_n(elemBlk_.begin() + first, cnt, blk.index());
+        first += cnt;
+    }
+    elemBlkOk_ = (elemCnt == first) && !blk.isValid();
+}
 
+
+bool
+CaeUnsUMCPSEG::lookupElemBlocks()
+{
+    // The element order assumed by buildElemBlocks() does not hold. Get the
+    // block of every element from the grid model.
+    const PWP_UINT32 elemCnt = model_.elementCount();
+    elemBlk_.resize(elemCnt);
+    PWGM_ENUMELEMDATA eed;
+    PWP_UINT32 ii = 0;
+    for (; ii < elemCnt; ++ii) {
+        const PWGM_HELEMENT hE = PwModEnumElements(model_.model(), ii);
+        if (!PwElemDataModEnum(hE, &eed)) {
+            sendErrorMsg("lookupElemBlocks: Could not get the block of an "
+                "element", ii);
+            break;
+        }
+        elemBlk_[ii] = PWGM_HELEMENT_PID(eed.hBlkElement);
+    }
+    elemBlkChecked_.assign(elemCnt, 1);
+    elemBlkOk_ = (elemCnt == ii);
+    return elemBlkOk_;
+}
+
+
+bool
+CaeUnsUMCPSEG::checkNborBlk(const PWP_UINT32 cell)
+{
+    // An element that is never the owner of a face is only seen as a
+    // neighbor. The first time, check its block against the grid model.
+    // Clears elemBlkOk_ on a mismatch so the blocks are looked up.
+    if (cell < elemBlkChecked_.size() && 0 == elemBlkChecked_[cell]) {
+        PWGM_ENUMELEMDATA eed;
+        const PWGM_HELEMENT hE = PwModEnumElements(model_.model(), cell);
+        elemBlkOk_ = elemBlkOk_ && PwElemDataModEnum(hE, &eed) &&
+            (elemBlk_[cell] == PWGM_HELEMENT_PID(eed.hBlkElement));
+        elemBlkChecked_[cell] = 1;
+    }
+    return elemBlkOk_;
+}
+
+
+bool
+CaeUnsUMCPSEG::loadVertices()
+{
+    // Pull the coordinates of every vertex into coords_ with a single pass
+    // over the grid model. All writers and the log use coords_ instead of
+    // CaeUnsVertex.
+    Stopwatch timer;
+    const PWP_UINT32 vertCnt = model_.vertexCount();
+    const PWP_UINT32 chunkCnt = (vertCnt + NodesPerChunk - 1) / NodesPerChunk;
+    coords_.resize(vertCnt);
+    bool ret = beginThrottledStep(chunkCnt);
+    CaeUnsVertex v(model_);
+    for (PWP_UINT32 ii = 0; ret && ii < vertCnt; ++ii, ++v) {
+        coords_.set(ii, v.x(), v.y(), v.z());
+        if (0 == (ii + 1) % NodesPerChunk || ii + 1 == vertCnt) {
+            ret = throttledIncrement();
+        }
+    }
+    progressEndStep();
     if (ret && log_.isOpen()) {
-        log_.writef("node %d {%g %g %g} %d %d %d %d %d {",
-            int(v.index() + 1), double(v.x()), double(v.y()), double(v.z()),
-            int(matId), int(hadMatConflict), int(ptInfo.isBndry() ? 1 : 0),
-            int(zoneId), int(hadZoneConflict));
-        UInt32Array1::const_iterator nit = ptInfo.nbors().begin();
-        log_.write((*nit) + 1);   // first neighbor
-        for (++nit; ptInfo.nbors().end() != nit; ++nit) {
-            log_.write((*nit) + 1, 0, " ");   // next neighbor
+        logWritef("# vertices: %lu fetched in %.3f sec\n",
+            (unsigned long)vertCnt, timer.seconds());
+    }
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::sortNbors()
+{
+    // The face stream order of the edges is not guaranteed. Optionally put
+    // each node's neighbors in a canonical order so the output only depends
+    // on the grid.
+    const PWP_UINT32 nodeCnt = nodeNbors_.nodeCount();
+    const PWP_UINT32 chunkCnt = (nodeCnt + NodesPerChunk - 1) / NodesPerChunk;
+    if (NborOrderIndex == nborOrder_) {
+        pool_.parallelFor(chunkCnt, [&](const PWP_UINT32 c) {
+            nodeNbors_.sortByIndex(c * NodesPerChunk,
+                std::min(nodeCnt, (c + 1) * NodesPerChunk));
+        });
+    }
+    else if (NborOrderAngle == nborOrder_) {
+        const bool ret = (nodeCnt == coords_.size());
+        if (!ret) {
+            sendErrorMsg("sortNbors: Invalid vertex coordinates");
+            return false;
         }
-        log_.write("}\n");
+        pool_.parallelFor(chunkCnt, [&](const PWP_UINT32 c) {
+            // the keys of one node at a time
+            ScratchDoubleArray1 keys;
+            nodeNbors_.sortByKey(c * NodesPerChunk,
+                std::min(nodeCnt, (c + 1) * NodesPerChunk),
+                [&](const PWP_UINT32 ndx, const PWP_UINT32 nbor) {
+                    const PWP_REAL *p0 = coords_.xyz(ndx);
+                    const PWP_REAL *p1 = coords_.xyz(nbor);
+                    return pseudoAngle(double(p1[0] - p0[0]),
+                        double(p1[1] - p0[1])); }, keys);
+        });
     }
+    return true;
+}
+
 
+bool
+CaeUnsUMCPSEG::loadElements()
+{
+    // Pull the connectivity of every element into elems_ with a single pass
+    // over the grid model. All later passes use elems_ instead of calling
+    // CaeUnsElement::data() again.
+    Stopwatch timer;
+    const PWP_UINT32 elemCnt = model_.elementCount();
+    const PWP_UINT32 chunkCnt = (elemCnt + ElemsPerChunk - 1) / ElemsPerChunk;
+    elems_.resize(elemCnt);
+    bool ret = beginThrottledStep(chunkCnt);
+    PWGM_ELEMDATA d;
+    CaeUnsElement e(model_);
+    for (PWP_UINT32 ii = 0; ret && ii < elemCnt; ++ii, ++e) {
+        if (!e.data(d)) {
+            ret = false;
+        }
+        else if (!elems_.set(ii, d)) {
+            sendErrorMsg("loadElements: Unexpected element type");
+            ret = false;
+        }
+        else if (0 == (ii + 1) % ElemsPerChunk || ii + 1 == elemCnt) {
+            ret = throttledIncrement();
+        }
+    }
+    progressEndStep();
+    if (ret && log_.isOpen()) {
+        logWritef("# elements: %lu fetched in %.3f sec\n",
+            (unsigned long)elemCnt, timer.seconds());
+    }
     return ret;
 }
 
 
+void
+CaeUnsUMCPSEG::nodeChunkMaxChars(const PWP_UINT32 first, const PWP_UINT32 last,
+    const bool doText, const bool doLog, size_t &textMax, size_t &logMax) const
+{
+    const size_t nodeCnt = size_t(last - first);
+    const size_t nborCnt = size_t(nodeNbors_.nborTotal(first, last));
+    textMax = doText ? (nodeCnt * (NodeLineMaxChars + 1) +
+        nborCnt * NlistNborMaxChars) : 0;
+    // A text line is never shorter than the binary record of a node
+    logMax = doLog ? (nodeCnt * NlistLog::nodeLineMaxChars(0) +
+        nborCnt * (NlistFormat::MaxIntChars + 1)) : 0;
+}
+
+
+PWP_UINT32
+CaeUnsUMCPSEG::nodeBatchEnd(const PWP_UINT32 c0, const bool doText,
+    const bool doLog, const size_t maxChars) const
+{
+    // Returns the end of the batch of node chunks that starts at chunk c0.
+    // A batch has at most numThreads_ * ChunksPerThread chunks, and unless
+    // it is a single chunk its chunk buffers need at most maxChars chars.
+    const PWP_UINT32 vertCnt = nodeNbors_.nodeCount();
+    const PWP_UINT32 chunkCnt = (vertCnt + NodesPerChunk - 1) / NodesPerChunk;
+    const PWP_UINT32 cMax = std::min(chunkCnt,
+        c0 + numThreads_ * ChunksPerThread);
+    PWP_UINT32 cEnd = c0;
+    size_t chars = 0;
+    while (cEnd < cMax) {
+        size_t textMax = 0;
+        size_t logMax = 0;
+        nodeChunkMaxChars(cEnd * NodesPerChunk,
+            std::min(vertCnt, (cEnd + 1) * NodesPerChunk), doText, doLog,
+            textMax, logMax);
+        chars += textMax + logMax;
+        if (cEnd > c0 && chars > maxChars) {
+            break;
+        }
+        ++cEnd;
+    }
+    return cEnd;
+}
+
+
+void
+CaeUnsUMCPSEG::formatNodes(NodeChunk &chunk, const PWP_UINT32 first,
+    const PWP_UINT32 last, const bool doText, const bool doLog) const
+{
+    // Called concurrently for different chunks. Must not touch model_, out_
+    // or logOut_.
+    size_t textMax = 0;
+    size_t logMax = 0;
+    nodeChunkMaxChars(first, last, doText, doLog, textMax, logMax);
+    if (chunk.text.size() < textMax) {
+        chunk.text.resize(textMax);
+    }
+    if (chunk.log.size() < logMax) {
+        chunk.log.resize(logMax);
+    }
+    chunk.isValid = true;
+    chunk.logCnt = 0;
+    char *p = chunk.text.data();
+    char *pLog = chunk.log.data();
+    for (PWP_UINT32 ndx = first; ndx < last; ++ndx) {
+        const PWP_REAL *xyz = coords_.xyz(ndx);
+        const UInt32Span nbors = nodeNbors_.nbors(ndx);
+        if (0 == nbors.size()) {
+            chunk.isValid = false;
+            break;
+        }
+
+        // line 1
+        //         1         2         3         4         5         6
+        //123456789012345678901234567890123456789012345678901234567890
+        // 6.85000000000000D-01 3.14500000000000D+00    5  0 0  0 1
+        //
+        // Same as writef("%21.14E%21.14E%5d %2d %c %2d%2d\n", ...)
+        bool hadMatConflict = false;
+        bool hadZoneConflict = false;
+        const MaterialId matId = nodeInfo_.getMaterial(ndx, hadMatConflict);
+        const ZoneId zoneId = nodeInfo_.getZone(ndx, hadZoneConflict);
+        const bool isBndry = nodeInfo_.isBndry(ndx);
+        if (doText) {
+            p = NlistFormat::expField(p, double(xyz[0]), 21, 14);
+            p = NlistFormat::expField(p, double(xyz[1]), 21, 14);
+            p = NlistFormat::intField(p, int(nbors.size()), 5);
+            *p++ = ' ';
+            p = NlistFormat::intField(p, int(matId), 2);
+            *p++ = ' ';
+            *p++ = NlistFormat::matIdChar(matId);
+            *p++ = ' ';
+            p = NlistFormat::intField(p, int(isBndry ? 1 : 0), 2);
+            p = NlistFormat::intField(p, int(zoneId), 2);
+            *p++ = '\n';
+        }
+
+        // line 2
+        //         1         2         3         4         5
+        //12345678901234567890123456789012345678901234567890
+        //     59   5513     60   5538   5539   2262   2251
+        //
+        // Same as writef("%7d", ...) for each neighbor followed by "\n"
+        if (1 == nbors.size()) {
+            // INVALID
+            assert(!"formatNodes: Only one neighbor");
+            continue;
+        }
+        if (doText) {
+            UInt32Span::const_iterator nit = nbors.begin();
+            for (; nbors.end() != nit; ++nit) {
+                p = NlistFormat::intField(p, int((*nit) + 1), 7);
+            }
+            *p++ = '\n';
+        }
+
+        if (doLog && logFilter_.matches(ndx, matId, zoneId, isBndry,
+                hadMatConflict || hadZoneConflict)) {
+            ++chunk.logCnt;
+            const double pt[3] = { double(xyz[0]), double(xyz[1]),
+                double(xyz[2]) };
+            PWP_UINT32 flags = 0;
+            if (isBndry) {
+                flags |= NlistBinary::NodeBndry;
+            }
+            if (hadMatConflict) {
+                flags |= NlistBinary::NodeMatConflict;
+            }
+            if (hadZoneConflict) {
+                flags |= NlistBinary::NodeZoneConflict;
+            }
+            pLog = binaryLog_ ?
+                NlistLog::putNode(pLog, ndx, pt, matId, zoneId, flags,
+                    nbors.size(), nbors.begin()) :
+                NlistLog::formatNode(pLog, ndx, pt, matId, zoneId, flags,
+                    nbors.size(), nbors.begin());
+        }
+    }
+    chunk.textLen = size_t(p - chunk.text.data());
+    chunk.logLen = size_t(pLog - chunk.log.data());
+}
+
+
 bool
 CaeUnsUMCPSEG::writeHeader()
+{
+    std::string text;
+    makeHeaderText(text);
+    return out_.write(text.c_str());
+}
+
+
+void
+CaeUnsUMCPSEG::makeHeaderText(std::string &text) const
 {
     char strTime[256];
     time_t szClock;
@@ -245,8 +952,12 @@ CaeUnsUMCPSEG::writeHeader()
 
     const char *appVer;
     model_.getAttribute("AppNameAndVersion", appVer, "Pointwise");
-    return rtFile_.write("POINTWISE\n") &&
-        rtFile_.writef("Created by %s on %s (%s)\n", appVer, strTime, appMach);
+
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "Created by %s on %s (%s)\n", appVer, strTime,
+        appMach);
+    text = "POINTWISE\n";
+    text += buf;
 }
 
 
@@ -258,24 +969,51 @@ CaeUnsUMCPSEG::writeNodes()
     //   7468     5          ***** NODES *****
     const PWP_UINT32 subType = 5; // indicates a POINTWISE generated file
     // changed subType to 5 in order for CPSEG to denote read changes
-    rtFile_.writef("%7d %5d          ***** NODES *****\n",
+    out_.writef("%7d %5d          ***** NODES *****\n",
         (int)model_.vertexCount(), (int)subType);
 
-    bool ret = progressBeginStep(model_.vertexCount());
+    // The nodes are formatted in chunks of NodesPerChunk nodes. Each batch of
+    // chunks is formatted in parallel and then written in order, so the output
+    // is the same for any number of threads. The chunk buffers of a batch
+    // hold at most about out_.capacity() chars.
+    const PWP_UINT32 vertCnt = model_.vertexCount();
+    const PWP_UINT32 chunkCnt = (vertCnt + NodesPerChunk - 1) / NodesPerChunk;
+    const PWP_UINT32 batchChunkCnt = numThreads_ * ChunksPerThread;
+    const bool doLog = log_.isOpen() && logFilter_.logsNodes();
+    bool ret = (vertCnt == nodeInfo_.size()) &&
+        (vertCnt == nodeNbors_.nodeCount()) && (vertCnt == coords_.size());
+    if (!ret) {
+        sendErrorMsg("Could not find neighbor points");
+    }
+    ret = ret && beginThrottledStep(chunkCnt);
     if (ret) {
-        CaeUnsVertex v(model_);
-        while (v.isValid()) {
-            NInfoMap::const_iterator it = nodeInfo_.find(v.index());
-            if (nodeInfo_.end() == it) {
-                sendErrorMsg("Could not find neighbor points");
-                ret = false;
-                break;
-            }
-            writeOneNode(v, it->second);
-            ++v;
-            if (!progressIncrement()) {
-                ret = false;
-                break;
+        NodeChunkArray1 chunks(batchChunkCnt);
+        for (PWP_UINT32 c0 = 0, cEnd = 0; ret && c0 < chunkCnt; c0 = cEnd) {
+            cEnd = nodeBatchEnd(c0, true, doLog, out_.capacity());
+            const PWP_UINT32 last = std::min(vertCnt, cEnd * NodesPerChunk);
+
+            pool_.parallelFor(cEnd - c0, [&](const PWP_UINT32 c) {
+                const PWP_UINT32 cFirst = (c0 + c) * NodesPerChunk;
+                const PWP_UINT32 cLast = std::min(last, cFirst + NodesPerChunk);
+                formatNodes(chunks[c], cFirst, cLast, true, doLog);
+            });
+
+            for (PWP_UINT32 c = 0; c < cEnd - c0; ++c) {
+                const NodeChunk &chunk = chunks[c];
+                out_.write(chunk.text.data(), chunk.textLen);
+                if (0 != chunk.logLen) {
+                    logOut_.write(chunk.log.data(), chunk.logLen);
+                    logNodeCnt_ += chunk.logCnt;
+                }
+                if (!chunk.isValid) {
+                    sendErrorMsg("Could not find neighbor points");
+                    ret = false;
+                    break;
+                }
+                if (!out_.isOk() || !throttledIncrement()) {
+                    ret = false;
+                    break;
+                }
             }
         }
     }
@@ -284,22 +1022,6 @@ CaeUnsUMCPSEG::writeNodes()
 }
 
 
-bool
-CaeUnsUMCPSEG::writeOneFace(const PWP_UINT32 n0, const PWP_UINT32 n1,
-    const PWP_UINT32 n2)
-{
-    //         1         2         3         4
-    //1234567890123456789012345678901234567890
-    //   6159   6173   6160   6160
-    // ...snip...
-    //   6175   6109   6174   6174
-    //
-    // yes, n2 is repeated (collapsed quad?)
-    return rtFile_.writef("%7d%7d%7d%7d\n", (int)(n0 + 1), (int)(n1 + 1),
-        (int)(n2 + 1), (int)(n2 + 1)) && progressIncrement();
-}
-
-
 bool
 CaeUnsUMCPSEG::writeFaces()
 {
@@ -309,30 +1031,94 @@ CaeUnsUMCPSEG::writeFaces()
     PWGM_ELEMCOUNTS cnts;
     model_.elementCount(&cnts);
     const int faceCnt = (int)(PWGM_ECNT_Quad(cnts) * 2 + PWGM_ECNT_Tri(cnts));
-    rtFile_.writef("%7d        ***** FACES *****\n", faceCnt);
+    out_.writef("%7d        ***** FACES *****\n", faceCnt);
+
+    // The elements are processed in batches of chunks. The face lines of
+    // each chunk are sized up front and a prefix sum gives each chunk its
+    // offset in the batch output. The chunks are then formatted in parallel
+    // directly into out_, at most out_.capacity() chars (or one chunk) at a
+    // time so a batch never grows the output buffer. Each chunk is split
+    // into runs of tris and quads that are formatted by the formatFaceRun()
+    // specializations.
+    Stopwatch timer;
+    const PWP_UINT32 elemCnt = elems_.size();
+    const PWP_UINT32 chunkCnt = (elemCnt + ElemsPerChunk - 1) / ElemsPerChunk;
+    const PWP_UINT32 batchChunkCnt = numThreads_ * ChunksPerThread;
+    // All face lines are FaceLineChars long unless an index needs more than
+    // 7 digits
+    const bool isFixedWidth = (model_.vertexCount() < 10000000);
+    const size_t lineChars = FaceLineChars;
+    bool ret = beginThrottledStep(chunkCnt);
+    if (ret) {
+        // The offset of each batch chunk's first face line (offsets[0] is 0)
+        SizeArray1 offsets(arena_);
+        for (PWP_UINT32 c0 = 0; ret && c0 < chunkCnt; c0 += batchChunkCnt) {
+            const PWP_UINT32 cEnd = std::min(chunkCnt, c0 + batchChunkCnt);
+            const PWP_UINT32 first = c0 * ElemsPerChunk;
+            const PWP_UINT32 last = std::min(elemCnt, cEnd * ElemsPerChunk);
+
+            offsets.assign(size_t(cEnd - c0) + 1, 0);
+            for (PWP_UINT32 ii = first; ii < last; ++ii) {
+                const PWP_UINT32 *v = elems_.verts(ii);
+                size_t chars;
+                if (!elems_.isQuad(ii)) {
+                    chars = (isFixedWidth ? lineChars :
+                        faceLineChars(v[0], v[1], v[2]));
+                }
+                else {
+                    // write quads as two tris
+                    chars = (isFixedWidth ? 2 * lineChars :
+                        (faceLineChars(v[0], v[1], v[2]) +
+                            faceLineChars(v[0], v[2], v[3])));
+                }
+                offsets[(ii - first) / ElemsPerChunk + 1] += chars;
+            }
+            for (PWP_UINT32 c = 0; c < cEnd - c0; ++c) {
+                offsets[c + 1] += offsets[c];
+            }
 
-    bool ret = progressBeginStep(model_.elementCount());
-    PWGM_ELEMDATA d;
-    CaeUnsElement e(model_);
-    while (ret && e.isValid()) {
-        if (!e.data(d)) {
-            ret = false;
-        }
-        else if (PWGM_ELEMTYPE_TRI == d.type) {
-            ret = writeOneFace(d.index[0], d.index[1], d.index[2]);
-        }
-        else if (PWGM_ELEMTYPE_QUAD == d.type) {
-            // write quads as two tris
-            ret = writeOneFace(d.index[0], d.index[1], d.index[2]) &&
-                writeOneFace(d.index[0], d.index[2], d.index[3]);
-        }
-        else {
-            sendErrorMsg("writeFaces: Unexpected element type");
-            ret = false;
+            // Batch chunks [cA, cB) are formatted together
+            for (PWP_UINT32 cA = 0, cB = 0; ret && cA < cEnd - c0; cA = cB) {
+                cB = cA + 1;
+                while (cB < cEnd - c0 &&
+                        offsets[cB + 1] - offsets[cA] <= out_.capacity()) {
+                    ++cB;
+                }
+                const size_t base = offsets[cA];
+                char * const buf = out_.reserve(offsets[cB] - base);
+                pool_.parallelFor(cB - cA, [&](const PWP_UINT32 cOff) {
+                    const PWP_UINT32 c = cA + cOff;
+                    const PWP_UINT32 cFirst = first + c * ElemsPerChunk;
+                    const PWP_UINT32 cLast = std::min(last,
+                        cFirst + ElemsPerChunk);
+                    char *p = buf + (offsets[c] - base);
+                    PWP_UINT32 ii = cFirst;
+                    while (ii < cLast) {
+                        // find the run of elements of the same type
+                        const bool isQuad = elems_.isQuad(ii);
+                        PWP_UINT32 runEnd = ii + 1;
+                        while (runEnd < cLast &&
+                                isQuad == elems_.isQuad(runEnd)) {
+                            ++runEnd;
+                        }
+                        p = formatFaceRun(p, elems_.verts(ii), runEnd - ii,
+                            isQuad, isFixedWidth);
+                        ii = runEnd;
+                    }
+                    assert(p == buf + (offsets[c + 1] - base));
+                    (void)p;
+                });
+                out_.commit(buf + (offsets[cB] - base));
+
+                ret = out_.isOk() && throttledIncrement(cB - cA);
+            }
         }
-        ++e;
     }
     progressEndStep();
+    if (ret && log_.isOpen()) {
+        logWritef("# elements: %lu formatted in %.3f sec\n",
+            (unsigned long)elemCnt, timer.seconds());
+    }
     return ret;
 }
 
@@ -343,39 +1129,464 @@ CaeUnsUMCPSEG::writeGeometry()
     //         1         2         3         4
     //1234567890123456789012345678901234567890
     //    906          ***** GEOMETRY *****
-    rtFile_.writef("%7d          ***** GEOMETRY *****\n",
+    out_.writef("%7d          ***** GEOMETRY *****\n",
         (int)geomEdges_.size());
 
-    bool ret = progressBeginStep(PWP_UINT32(geomEdges_.size()));
+    const PWP_UINT32 edgeCnt = PWP_UINT32(geomEdges_.size());
+    bool ret = beginThrottledStep(edgeCnt);
     if (ret) {
         //         1         2         3         4
         //1234567890123456789012345678901234567890
         //  0.00000E+00  0.00000E+00  2.02000E-01  0.00000E+00
         // ...snip...
         //  2.02000E-01  0.00000E+00  4.04000E-01  0.00000E+00
-        EdgeArray1::const_iterator it;
-        for (it = geomEdges_.begin(); geomEdges_.end() != it; ++it) {
-            const CaeUnsVertex v0(model_, it->first);
-            const CaeUnsVertex v1(model_, it->second);
-            rtFile_.writef("%13.5E%13.5E%13.5E%13.5E\n", double(v0.x()),
-                double(v0.y()), double(v1.x()), double(v1.y()));
-            if (log_.isOpen()) {
-                log_.writef("edge %d {%g %g %g} %d {%g %g %g}\n",
-                    int(it->first), double(v0.x()), double(v0.y()),
-                    double(v0.z()), int(it->second), double(v1.x()),
-                    double(v1.y()), double(v1.z()));
+        //
+        // Same as writef("%13.5E%13.5E%13.5E%13.5E\n", ...)
+        // Progress is counted per edge but only passed on once per
+        // EdgesPerChunk edges
+        for (PWP_UINT32 ii = 0; ret && ii < edgeCnt; ++ii) {
+            const Edge &e = geomEdges_[ii];
+            const PWP_REAL *v0 = coords_.xyz(e.first);
+            const PWP_REAL *v1 = coords_.xyz(e.second);
+            char *p = out_.reserve(NlistLineMaxChars);
+            p = NlistFormat::expField(p, double(v0[0]), 13, 5);
+            p = NlistFormat::expField(p, double(v0[1]), 13, 5);
+            p = NlistFormat::expField(p, double(v1[0]), 13, 5);
+            p = NlistFormat::expField(p, double(v1[1]), 13, 5);
+            *p++ = '\n';
+            out_.commit(p);
+            logEdge(e);
+            if (0 == (ii + 1) % EdgesPerChunk || ii + 1 == edgeCnt) {
+                ret = throttledIncrement((ii % EdgesPerChunk) + 1);
             }
-            if (!progressIncrement()) {
-                ret = false;
-                break;
+        }
+    }
+    progressEndStep();
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::flushOutput()
+{
+    // write() detaches out_ instead. Only used to end a single phase.
+    return out_.flush();
+}
+
+
+void
+CaeUnsUMCPSEG::logEdge(const Edge &e)
+{
+    if (log_.isOpen() && logFilter_.logsNodes() && (logFilter_.logsAll() ||
+            isNodeLogged(e.first) || isNodeLogged(e.second))) {
+        ++logEdgeCnt_;
+        const PWP_REAL *v0 = coords_.xyz(e.first);
+        const PWP_REAL *v1 = coords_.xyz(e.second);
+        const double pt0[3] = { double(v0[0]), double(v0[1]), double(v0[2]) };
+        const double pt1[3] = { double(v1[0]), double(v1[1]), double(v1[2]) };
+        char *p = logOut_.reserve(NlistLog::EdgeLineMaxChars);
+        p = binaryLog_ ?
+            NlistLog::putEdge(p, e.first, pt0, e.second, pt1) :
+            NlistLog::formatEdge(p, e.first, pt0, e.second, pt1);
+        logOut_.commit(p);
+    }
+}
+
+
+bool
+CaeUnsUMCPSEG::isNodeLogged(const PWP_UINT32 ndx) const
+{
+    bool hadMatConflict = false;
+    bool hadZoneConflict = false;
+    const MaterialId matId = nodeInfo_.getMaterial(ndx, hadMatConflict);
+    const ZoneId zoneId = nodeInfo_.getZone(ndx, hadZoneConflict);
+    return logFilter_.matches(ndx, matId, zoneId, nodeInfo_.isBndry(ndx),
+        hadMatConflict || hadZoneConflict);
+}
+
+void
+CaeUnsUMCPSEG::logText(const char *text)
+{
+    // A binary log keeps the text as a Text record
+    const size_t len = strlen(text);
+    if (!binaryLog_) {
+        logOut_.write(text, len);
+    }
+    else {
+        char *p = logOut_.reserve(NlistLog::RecordHeaderBytes + len);
+        logOut_.commit(NlistLog::putText(p, text, len));
+    }
+}
+
+
+void
+CaeUnsUMCPSEG::logWritef(const char *fmt, ...)
+{
+    // Most lines fit buf. Longer ones (long filter lists) are formatted again
+    // into a heap buffer of the size vsnprintf() asked for.
+    va_list args;
+    va_start(args, fmt);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    char buf[1024];
+    const int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (len < 0) {
+        // encoding error, nothing to log
+    }
+    else if (size_t(len) < sizeof(buf)) {
+        logText(buf);
+    }
+    else {
+        std::vector<char> heapBuf(size_t(len) + 1);
+        vsnprintf(heapBuf.data(), heapBuf.size(), fmt, argsCopy);
+        logText(heapBuf.data());
+    }
+    va_end(argsCopy);
+}
+
+
+bool
+CaeUnsUMCPSEG::logNodes()
+{
+    // The binary writers do not format the NODES text. Format only the node
+    // log lines, at most about logOut_.capacity() chars per batch.
+    const PWP_UINT32 vertCnt = nodeNbors_.nodeCount();
+    const PWP_UINT32 chunkCnt = (vertCnt + NodesPerChunk - 1) / NodesPerChunk;
+    const PWP_UINT32 batchChunkCnt = numThreads_ * ChunksPerThread;
+    NodeChunkArray1 chunks(batchChunkCnt);
+    bool ret = true;
+    for (PWP_UINT32 c0 = 0, cEnd = 0; ret && c0 < chunkCnt; c0 = cEnd) {
+        cEnd = nodeBatchEnd(c0, false, true, logOut_.capacity());
+        const PWP_UINT32 last = std::min(vertCnt, cEnd * NodesPerChunk);
+        pool_.parallelFor(cEnd - c0, [&](const PWP_UINT32 c) {
+            const PWP_UINT32 cFirst = (c0 + c) * NodesPerChunk;
+            const PWP_UINT32 cLast = std::min(last, cFirst + NodesPerChunk);
+            formatNodes(chunks[c], cFirst, cLast, false, true);
+        });
+        for (PWP_UINT32 c = 0; ret && c < cEnd - c0; ++c) {
+            const NodeChunk &chunk = chunks[c];
+            if (0 != chunk.logLen) {
+                logOut_.write(chunk.log.data(), chunk.logLen);
+                logNodeCnt_ += chunk.logCnt;
             }
+            ret = chunk.isValid;
         }
     }
+    return ret;
+}
+
+
+static NlistBinary::Section
+makeSection(const NlistBinary::SectionId id, const PWP_UINT32 param,
+    const size_t count)
+{
+    NlistBinary::Section ret;
+    ret.id = PWP_UINT32(id);
+    ret.param = param;
+    ret.count = count;
+    ret.offset = 0;
+    ret.bytes = 0;
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::writeBinary()
+{
+    // Same data as the ASCII sections. See NlistBinary.h for the layout.
+    const PWP_UINT32 vertCnt = coords_.size();
+    bool ret = (vertCnt == nodeInfo_.size()) &&
+        (vertCnt == nodeNbors_.nodeCount());
+    for (PWP_UINT32 ndx = 0; ret && ndx < vertCnt; ++ndx) {
+        ret = (0 != nodeNbors_.nborCount(ndx));
+    }
+    if (!ret) {
+        sendErrorMsg("Could not find neighbor points");
+        return false;
+    }
+
+    std::string text;
+    makeHeaderText(text);
+
+    // The FACES offset of each chunk of elements
+    const PWP_UINT32 elemCnt = elems_.size();
+    const PWP_UINT32 elemChunkCnt = (elemCnt + ElemsPerChunk - 1) /
+        ElemsPerChunk;
+    faceChunkOffsets_.assign(size_t(elemChunkCnt) + 1, 0);
+    for (PWP_UINT32 ii = 0; ii < elemCnt; ++ii) {
+        faceChunkOffsets_[ii / ElemsPerChunk + 1] += (elems_.isQuad(ii) ?
+            2 : 1);
+    }
+    for (PWP_UINT32 c = 0; c < elemChunkCnt; ++c) {
+        faceChunkOffsets_[c + 1] += faceChunkOffsets_[c];
+    }
+
+    const PWP_UINT32 subType = 5; // indicates a POINTWISE generated file
+    NlistBinary::SectionArray1 secs;
+    secs.push_back(makeSection(NlistBinary::Header, 0, text.size()));
+    secs.push_back(makeSection(NlistBinary::NodeXY, subType, vertCnt));
+    secs.push_back(makeSection(NlistBinary::NodeAttr, 0, vertCnt));
+    secs.push_back(makeSection(NlistBinary::NodeNborOffsets, 0,
+        size_t(vertCnt) + 1));
+    secs.push_back(makeSection(NlistBinary::NodeNbors, 0,
+        nodeNbors_.nborTotal(0, vertCnt)));
+    secs.push_back(makeSection(NlistBinary::Faces, 0,
+        faceChunkOffsets_.back()));
+    secs.push_back(makeSection(NlistBinary::Geometry, 0, geomEdges_.size()));
+    NlistBinary::layout(secs);
+
+    // The file size is known. Write directly into a mapping of the file if
+    // possible, otherwise stream the sections through out_. map_ opens the
+    // export file a second time. rtFile_ stays open but is left empty: every
+    // plugin write to rtFile_ goes through out_, and nothing has been written
+    // to out_ yet, so rtFile_ has no data to flush over the mapped file.
+    // ASSUMES the PluginSDK only flushes and closes rtFile_ when the export
+    // is done: it must not truncate, rewrite, rename or delete fileDest
+    // after the plugin returns. The PwpFile API gives no access to the
+    // descriptor of rtFile_, and the harness stand-in cannot show what the
+    // SDK does. Set MapOutputFile to false if a host breaks this assumption.
+    const NlistBinary::Section &last = secs.back();
+    const size_t fileBytes = size_t(NlistBinary::align(last.offset +
+        last.bytes));
+    assert(0 == out_.bytesWritten());
+    if (useMap_ && 0 == out_.bytesWritten() &&
+            !map_.open(writeInfo_.fileDest, fileBytes)) {
+        sendWarningMsg("Could not map the output file. Using buffered "
+            "output.");
+    }
+    if (map_.isOpen()) {
+        stats_.add(ExportStats::CountBytesWritten, fileBytes);
+    }
+
+    char *p = binReserve(0, size_t(NlistBinary::tableBytes(secs)));
+    binCommit(NlistBinary::putTable(p, secs));
+    p = binReserve(secs[0].offset, text.size());
+    memcpy(p, text.data(), text.size());
+    binCommit(p + text.size());
+    ret = writeBinPad(secs[0]) && writeBinNodes(secs[1], secs[2], secs[3],
+        secs[4]) && (!log_.isOpen() ||
+        !logFilter_.logsNodes() || logNodes()) &&
+        writeBinFaces(secs[5]) && writeBinGeometry(secs[6]);
+    if (map_.isOpen() && !map_.close()) {
+        sendErrorMsg("Could not write the mapped output file");
+        ret = false;
+    }
+    releaseArray(faceChunkOffsets_);
+    return ret;
+}
+
+
+char*
+CaeUnsUMCPSEG::binReserve(const PWP_UINT64 offset, const size_t cnt)
+{
+    // The streamed sections are written in file order, so offset is only
+    // needed for the mapped file.
+    return map_.isOpen() ? (map_.data() + offset) : out_.reserve(cnt);
+}
+
+
+void
+CaeUnsUMCPSEG::binCommit(const char *end)
+{
+    if (!map_.isOpen()) {
+        out_.commit(end);
+    }
+}
+
+
+bool
+CaeUnsUMCPSEG::writeBinPad(const NlistBinary::Section &sec)
+{
+    // The mapped file is zero filled when it is created
+    const size_t cnt = size_t(NlistBinary::align(sec.bytes) - sec.bytes);
+    if (!map_.isOpen()) {
+        char *p = out_.reserve(cnt);
+        out_.commit(NlistBinary::putPad(p, cnt));
+    }
+    return out_.isOk();
+}
+
+
+template<typename OffsetFunc, typename EncodeFunc>
+bool
+CaeUnsUMCPSEG::writeBinSection(const NlistBinary::Section &sec,
+    const PWP_UINT32 chunkCnt, const OffsetFunc &offset,
+    const EncodeFunc &encode)
+{
+    // offset(c) is the byte offset of chunk c in the section (offset(chunkCnt)
+    // is the section size). encode(p, c) writes chunk c to p and returns the
+    // end of the written bytes. The mapped chunks are written in parallel.
+    // The calling thread passes on the progress of all threads between its
+    // own chunks, so an abort stops the section after a few chunks.
+    bool ret = true;
+    if (map_.isOpen()) {
+        char * const base = map_.data() + sec.offset;
+        PWP_UINT32 reported = 0;
+        ret = pool_.parallelForPolled(chunkCnt,
+            [&](const PWP_UINT32 c) {
+                const char *end = encode(base + offset(c), c);
+                assert(end == base + offset(c + 1));
+                (void)end; },
+            [&](const PWP_UINT32 doneCnt) {
+                const bool ok = throttledIncrement(doneCnt - reported);
+                reported = doneCnt;
+                return ok; });
+    }
+    else {
+        for (PWP_UINT32 c = 0; ret && c < chunkCnt; ++c) {
+            char *p = out_.reserve(size_t(offset(c + 1) - offset(c)));
+            out_.commit(encode(p, c));
+            ret = out_.isOk() && throttledIncrement();
+        }
+    }
+    return ret && writeBinPad(sec);
+}
+
+
+bool
+CaeUnsUMCPSEG::writeBinNodes(const NlistBinary::Section &xySec,
+    const NlistBinary::Section &attrSec, const NlistBinary::Section &offsetSec,
+    const NlistBinary::Section &nborSec)
+{
+    const PWP_UINT32 vertCnt = coords_.size();
+    const PWP_UINT32 chunkCnt = (vertCnt + NodesPerChunk - 1) / NodesPerChunk;
+    auto chunkFirst = [=](const PWP_UINT32 c) {
+        return std::min(vertCnt, c * NodesPerChunk); };
+    bool ret = beginThrottledStep(4 * chunkCnt);
+
+    // NodeXY
+    ret = ret && writeBinSection(xySec, chunkCnt,
+        [&](const PWP_UINT32 c) { return size_t(chunkFirst(c)) * 16; },
+        [&](char *p, const PWP_UINT32 c) {
+            for (PWP_UINT32 ndx = chunkFirst(c); ndx < chunkFirst(c + 1);
+                    ++ndx) {
+                const PWP_REAL *xyz = coords_.xyz(ndx);
+                p = NlistBinary::putF64(p, double(xyz[0]));
+                p = NlistBinary::putF64(p, double(xyz[1]));
+            }
+            return p; });
+
+    // NodeAttr
+    ret = ret && writeBinSection(attrSec, chunkCnt,
+        [&](const PWP_UINT32 c) { return size_t(chunkFirst(c)) * 12; },
+        [&](char *p, const PWP_UINT32 c) {
+            for (PWP_UINT32 ndx = chunkFirst(c); ndx < chunkFirst(c + 1);
+                    ++ndx) {
+                bool hadMatConflict = false;
+                bool hadZoneConflict = false;
+                const MaterialId matId = nodeInfo_.getMaterial(ndx,
+                    hadMatConflict);
+                const ZoneId zoneId = nodeInfo_.getZone(ndx,
+                    hadZoneConflict);
+                PWP_UINT32 flags = 0;
+                if (nodeInfo_.isBndry(ndx)) {
+                    flags |= NlistBinary::NodeBndry;
+                }
+                if (hadMatConflict) {
+                    flags |= NlistBinary::NodeMatConflict;
+                }
+                if (hadZoneConflict) {
+                    flags |= NlistBinary::NodeZoneConflict;
+                }
+                p = NlistBinary::putI32(p, matId);
+                p = NlistBinary::putI32(p, zoneId);
+                p = NlistBinary::putU32(p, flags);
+            }
+            return p; });
+
+    // NodeNborOffsets. Chunk 0 also writes the leading 0.
+    ret = ret && writeBinSection(offsetSec, chunkCnt,
+        [&](const PWP_UINT32 c) {
+            return (0 == c) ? 0 : (size_t(chunkFirst(c)) + 1) * 4; },
+        [&](char *p, const PWP_UINT32 c) {
+            if (0 == c) {
+                p = NlistBinary::putU32(p, 0);
+            }
+            for (PWP_UINT32 ndx = chunkFirst(c); ndx < chunkFirst(c + 1);
+                    ++ndx) {
+                p = NlistBinary::putU32(p, nodeNbors_.nborTotal(0, ndx + 1));
+            }
+            return p; });
+
+    // NodeNbors
+    ret = ret && writeBinSection(nborSec, chunkCnt,
+        [&](const PWP_UINT32 c) {
+            return size_t(nodeNbors_.nborTotal(0, chunkFirst(c))) * 4; },
+        [&](char *p, const PWP_UINT32 c) {
+            for (PWP_UINT32 ndx = chunkFirst(c); ndx < chunkFirst(c + 1);
+                    ++ndx) {
+                const UInt32Span nbors = nodeNbors_.nbors(ndx);
+                UInt32Span::const_iterator nit = nbors.begin();
+                for (; nbors.end() != nit; ++nit) {
+                    p = NlistBinary::putU32(p, *nit);
+                }
+            }
+            return p; });
     progressEndStep();
     return ret;
 }
 
 
+bool
+CaeUnsUMCPSEG::writeBinFaces(const NlistBinary::Section &sec)
+{
+    const PWP_UINT32 elemCnt = elems_.size();
+    const PWP_UINT32 chunkCnt = PWP_UINT32(faceChunkOffsets_.size() - 1);
+    bool ret = beginThrottledStep(chunkCnt);
+    ret = ret && writeBinSection(sec, chunkCnt,
+        [&](const PWP_UINT32 c) { return faceChunkOffsets_[c] * 12; },
+        [&](char *p, const PWP_UINT32 c) {
+            const PWP_UINT32 last = std::min(elemCnt, (c + 1) * ElemsPerChunk);
+            for (PWP_UINT32 ii = c * ElemsPerChunk; ii < last; ++ii) {
+                // write quads as two tris
+                const PWP_UINT32 *v = elems_.verts(ii);
+                p = NlistBinary::putU32(p, v[0]);
+                p = NlistBinary::putU32(p, v[1]);
+                p = NlistBinary::putU32(p, v[2]);
+                if (elems_.isQuad(ii)) {
+                    p = NlistBinary::putU32(p, v[0]);
+                    p = NlistBinary::putU32(p, v[2]);
+                    p = NlistBinary::putU32(p, v[3]);
+                }
+            }
+            return p; });
+    progressEndStep();
+    return ret;
+}
+
+
+bool
+CaeUnsUMCPSEG::writeBinGeometry(const NlistBinary::Section &sec)
+{
+    const PWP_UINT32 edgeCnt = PWP_UINT32(geomEdges_.size());
+    const PWP_UINT32 chunkCnt = (edgeCnt + EdgesPerChunk - 1) / EdgesPerChunk;
+    auto chunkFirst = [=](const PWP_UINT32 c) {
+        return std::min(edgeCnt, c * EdgesPerChunk); };
+    bool ret = beginThrottledStep(chunkCnt);
+    ret = ret && writeBinSection(sec, chunkCnt,
+        [&](const PWP_UINT32 c) { return size_t(chunkFirst(c)) * 32; },
+        [&](char *p, const PWP_UINT32 c) {
+            for (PWP_UINT32 ii = chunkFirst(c); ii < chunkFirst(c + 1); ++ii) {
+                const PWP_REAL *v0 = coords_.xyz(geomEdges_[ii].first);
+                const PWP_REAL *v1 = coords_.xyz(geomEdges_[ii].second);
+                p = NlistBinary::putF64(p, double(v0[0]));
+                p = NlistBinary::putF64(p, double(v0[1]));
+                p = NlistBinary::putF64(p, double(v1[0]));
+                p = NlistBinary::putF64(p, double(v1[1]));
+            }
+            return p; });
+    progressEndStep();
+    if (ret && log_.isOpen()) {
+        EdgeArray1::const_iterator it;
+        for (it = geomEdges_.begin(); geomEdges_.end() != it; ++it) {
+            logEdge(*it);
+        }
+    }
+    return ret;
+}
+
+
 //===========================================================================
 // face streaming handlers
 //===========================================================================
@@ -383,19 +1594,40 @@ CaeUnsUMCPSEG::writeGeometry()
 PWP_UINT32
 CaeUnsUMCPSEG::streamBegin(const PWGM_BEGINSTREAM_DATA &data)
 {
-    // This is a rough guess
-    geomEdges_.reserve(data.numBoundaryFaces * 2);
+    // Vertex indices are dense. Create a default entry for every vertex up
+    // front so that pushPt() never has to search or insert.
+    streamCnts_ = data;
+    nodeInfo_.resize(model_.vertexCount());
+    nodeNbors_.clear();
+    // Every streamed edge is captured for nodeNbors_. With one thread the
+    // edges are classified as they arrive, so their face data is not kept.
+    serialStream_ = (1 == numThreads_);
+    edges_.clear();
+    edges_.reserve(data.totalNumFaces);
+    edgeRecs_.clear();
+    streamGeomEdges_.clear();
+    if (!serialStream_) {
+        edgeRecs_.reserve(data.totalNumFaces);
+    }
+    stats_.set(ExportStats::CountBndryEdges, 0);
+    stats_.set(ExportStats::CountIntorEdges, 0);
+    stats_.set(ExportStats::CountCnxnEdges, 0);
+    // Reserved with the exact count once the edges are classified
+    releaseArray(geomEdges_);
     return 1;
 }
 
 
 /* Each node has a VC-assigned material and zone id, a BC-assigned material and
    zone id, and a list of neighbor nodes. Initially these values are all
-   undefined/empty. See class NodeInfo.
-
-   Examine the edge's BC and its owner/neighbor VCs and push the appropriate
-   material id and zone id values to each of the edge's nodes. The data is
-   pushed to each node with the other node as its neighbor. A higher zone id
+   undefined/empty. See classes NodeTable and NodeNbors.
+
+   streamFace() captures the edge and its raw face data. Once all edges are
+   captured, classifyEdges() examines each edge's BC and its owner/neighbor
+   VCs and buildNodeTables() pushes the appropriate material id and zone id
+   values to each of the edge's nodes. A serial stream does both for each edge
+   as it arrives and only keeps the edge. Each node gets the other node as its
+   neighbor when nodeNbors_ is built by buildNodeTables(). A higher zone id
    value will overwrite a lower zone id value.
 
    Once all edges have been processed, each node will have a final material and
@@ -408,79 +1640,329 @@ CaeUnsUMCPSEG::streamFace(const PWGM_FACESTREAM_DATA &data)
     // Since this is a 2D exporter, data defines an edge (PWGM_ELEMTYPE_BAR).
     PWP_UINT32 ret = 0;
     if (PWGM_ELEMTYPE_BAR == data.elemData.type) {
-        const bool isBndry = (PWGM_FACETYPE_BOUNDARY == data.type);
-        const PWP_UINT32 &ndx0 = data.elemData.index[0];
-        const PWP_UINT32 &ndx1 = data.elemData.index[1];
-        MaterialId matId = 0;
-        ZoneId zoneId = UndefinedId;
-        bool mzFromVC = false; // true if matId and zoneId came from a VC
-        bool isGeomEdge = false; // true if edge should be added to geomEdges_
-        if (getEdgeMatAndZone(data, matId, zoneId, mzFromVC, isGeomEdge) &&
-                pushPt(ndx0, ndx1, matId, zoneId, mzFromVC, isBndry) &&
-                pushPt(ndx1, ndx0, matId, zoneId, mzFromVC, isBndry)) {
-            if (isGeomEdge) {
-                geomEdges_.push_back(Edge(ndx0, ndx1));
-            }
+        EdgeRec rec;
+        rec.type = data.type;
+        rec.ownerBlk = PWGM_HBLOCK_ID(data.owner.block);
+        rec.ownerDom = PWGM_HDOMAIN_ISVALID(data.owner.domain) ?
+            PWGM_HDOMAIN_ID(data.owner.domain) : PWP_UINT32_UNDEF;
+        rec.nborCell = data.neighborCellIndex;
+        const PWP_UINT32 ownerCell = data.owner.cellIndex;
+        elemBlkOk_ = elemBlkOk_ && (ownerCell < elemBlk_.size()) &&
+            (elemBlk_[ownerCell] == rec.ownerBlk);
+        if (elemBlkOk_) {
+            elemBlkChecked_[ownerCell] = 1;
+        }
+        rec.matId = MatUndefined;
+        rec.zoneId = ZoneUndefined;
+        rec.flags = 0;
+        const Edge e(data.elemData.index[0], data.elemData.index[1]);
+        edges_.push_back(e);
+        if (!serialStream_) {
+            edgeRecs_.push_back(rec);
+            ret = 1;
+        }
+        else if (elemBlkOk_ && checkNborBlk(rec.nborCell) &&
+                classifyStreamedEdge(e, rec)) {
             ret = 1;
         }
+        // else stop the stream. streamEdges() streams again once the
+        // blocks are looked up.
     }
     return ret;
 }
 
 
 PWP_UINT32
-CaeUnsUMCPSEG::streamEnd(const PWGM_ENDSTREAM_DATA & /*data*/)
+CaeUnsUMCPSEG::streamEnd(const PWGM_ENDSTREAM_DATA &data)
 {
-    return 1;
+    // All edges are known. Classify them, init() builds the node tables. A
+    // serial stream only has to collect its geometry edges.
+    stats_.start(ExportStats::PhaseClassify);
+    bool ret = (PWP_FALSE != data.ok);
+    if (!ret) {
+        // the stream was stopped
+    }
+    else if (serialStream_) {
+        geomEdges_.reserve(streamGeomEdges_.size());
+        geomEdges_.assign(streamGeomEdges_.begin(), streamGeomEdges_.end());
+        StreamEdgeArray1().swap(streamGeomEdges_);
+        stats_.set(ExportStats::CountGeomEdges, geomEdges_.size());
+        logEdgeSizing(edges_.size());
+    }
+    else {
+        // Every owner element is checked. Check the neighbor elements.
+        EdgeRecArray1::const_iterator it = edgeRecs_.begin();
+        for (; elemBlkOk_ && edgeRecs_.end() != it; ++it) {
+            checkNborBlk(it->nborCell);
+        }
+        ret = (elemBlkOk_ || lookupElemBlocks()) && classifyEdges();
+    }
+    stats_.stop(ExportStats::PhaseClassify);
+    return ret ? 1 : 0;
 }
 
 
 bool
-CaeUnsUMCPSEG::getPoint(const PWP_UINT32 vPt, NInfoIter &it,
-    const bool allowCreate)
+CaeUnsUMCPSEG::classifyStreamedEdge(const Edge &e, EdgeRec &rec)
 {
-    it = nodeInfo_.find(vPt);
-    if (allowCreate && (nodeInfo_.end() == it)) {
-        // vPt is new - create default map entry
-        it = nodeInfo_.insert(NInfoMapVal(vPt, NodeInfo())).first;
+    // Same result as classifyEdges() and the serial push of
+    // buildNodeTables() for one edge
+    classifyEdge(rec);
+    const bool ret = (0 != (rec.flags & EdgeRec::IsValid)) &&
+        (e.first < nodeInfo_.size()) && (e.second < nodeInfo_.size());
+    if (ret) {
+        if (0 != (rec.flags & EdgeRec::IsGeomEdge)) {
+            streamGeomEdges_.push_back(e);
+        }
+        countEdgeType(rec.type);
+        pushPt(e.first, rec);
+        pushPt(e.second, rec);
     }
-    return nodeInfo_.end() != it;
+    return ret;
 }
 
 
-NInfoIter
-CaeUnsUMCPSEG::addPoint(const PWP_UINT32 vPt)
+void
+CaeUnsUMCPSEG::countEdgeType(const PWGM_ENUM_FACETYPE type)
+{
+    switch (type) {
+    case PWGM_FACETYPE_BOUNDARY:
+        stats_.add(ExportStats::CountBndryEdges, 1);
+        break;
+    case PWGM_FACETYPE_INTERIOR:
+        stats_.add(ExportStats::CountIntorEdges, 1);
+        break;
+    case PWGM_FACETYPE_CONNECTION:
+        stats_.add(ExportStats::CountCnxnEdges, 1);
+        break;
+    default:
+        break;
+    }
+}
+
+
+void
+CaeUnsUMCPSEG::logEdgeSizing(const size_t edgeCnt)
 {
-    NInfoIter it;
-    getPoint(vPt, it, true);
-    assert(it != nodeInfo_.end());
-    return it;
+    if (log_.isOpen()) {
+        // Every container is sized from the stream counts. Report how far
+        // they were from what was actually streamed.
+        logSizing("boundary edges", streamCnts_.numBoundaryFaces,
+            size_t(stats_.count(ExportStats::CountBndryEdges)));
+        logSizing("interior edges", streamCnts_.numInteriorFaces,
+            size_t(stats_.count(ExportStats::CountIntorEdges)));
+        logSizing("connection edges", streamCnts_.numConnections,
+            size_t(stats_.count(ExportStats::CountCnxnEdges)));
+        logSizing("edges", streamCnts_.totalNumFaces, edgeCnt);
+    }
 }
 
 
 bool
-CaeUnsUMCPSEG::pushPt(const PWP_UINT32 vPt, const PWP_UINT32 vNbor,
-    const MaterialId matId, const ZoneId zoneId, const bool mzFromVC,
-    const bool isBndry)
+CaeUnsUMCPSEG::classifyEdges()
 {
-    NInfoIter it;
-    const bool ret = getPoint(vPt, it, true);
+    // Classify the edges in parallel chunks. Each edge only touches its own
+    // EdgeRec.
+    const PWP_UINT32 edgeCnt = PWP_UINT32(edges_.size());
+    const PWP_UINT32 chunkCnt = (edgeCnt + EdgesPerChunk - 1) / EdgesPerChunk;
+    // The number of geometry edges in each chunk
+    SizeArray1 geomCnts(chunkCnt, 0, arena_);
+    pool_.parallelFor(chunkCnt, [&](const PWP_UINT32 c) {
+        const PWP_UINT32 last = std::min(edgeCnt, (c + 1) * EdgesPerChunk);
+        size_t geomCnt = 0;
+        for (PWP_UINT32 ii = c * EdgesPerChunk; ii < last; ++ii) {
+            classifyEdge(edgeRecs_[ii]);
+            if (0 != (edgeRecs_[ii].flags & EdgeRec::IsGeomEdge)) {
+                ++geomCnt;
+            }
+        }
+        geomCnts[c] = geomCnt;
+    });
+
+    size_t geomTotal = 0;
+    for (PWP_UINT32 c = 0; c < chunkCnt; ++c) {
+        geomTotal += geomCnts[c];
+    }
+    geomEdges_.reserve(geomTotal);
+
+    // Validate and collect the geometry edges in stream order. Count the
+    // captured edges of each face type.
+    bool ret = true;
+    for (PWP_UINT32 ii = 0; ii < edgeCnt; ++ii) {
+        const Edge &e = edges_[ii];
+        const EdgeRec &rec = edgeRecs_[ii];
+        if (0 == (rec.flags & EdgeRec::IsValid) ||
+                e.first >= nodeInfo_.size() || e.second >= nodeInfo_.size()) {
+            ret = false;
+            break;
+        }
+        if (0 != (rec.flags & EdgeRec::IsGeomEdge)) {
+            geomEdges_.push_back(e);
+        }
+        countEdgeType(rec.type);
+    }
+    stats_.set(ExportStats::CountGeomEdges, geomEdges_.size());
     if (ret) {
-        NodeInfo &ni = it->second;
-        ni.nbors().push_back(vNbor);
-        if (isBndry) {
-            ni.setBndry();
+        logEdgeSizing(edgeCnt);
+    }
+    return ret;
+}
+
+
+void
+CaeUnsUMCPSEG::buildNodeTables()
+{
+    // Push the edge ids to the nodes. Each thread owns a shard of the nodes
+    // and applies the edges that touch its shard in stream order, so the
+    // ManagedId "max id wins, record conflict" result of each node is the
+    // same as a serial push. The shards are disjoint, so merging them is a
+    // no-op.
+    //
+    // The edges are first bucketed by shard. The edges are split into one
+    // range per shard. Each range counts the edges it adds to each bucket,
+    // a prefix sum over the buckets (and the ranges in stream order) gives
+    // each range its offset in each bucket, and then each range fills its
+    // part of the buckets. Each bucket keeps the stream order and each edge
+    // is read twice in total for any number of shards.
+    const PWP_UINT32 nodeCnt = nodeInfo_.size();
+    const PWP_UINT32 edgeCnt = PWP_UINT32(edges_.size());
+    const PWP_UINT32 shardCnt = std::max(PWP_UINT32(1),
+        std::min(numThreads_, PWP_UINT32(nodeCnt / NodesPerChunk)));
+    const PWP_UINT32 shardSize = (nodeCnt + shardCnt - 1) / shardCnt;
+    if (serialStream_) {
+        // the ids were pushed as the edges were streamed
+    }
+    else if (1 == shardCnt) {
+        for (PWP_UINT32 ii = 0; ii < edgeCnt; ++ii) {
+            pushPt(edges_[ii].first, edgeRecs_[ii]);
+            pushPt(edges_[ii].second, edgeRecs_[ii]);
         }
+    }
+    else {
+        // The buckets only live for this call. They use the heap so that
+        // their memory is returned right away.
+        const PWP_UINT32 rangeSize = (edgeCnt + shardCnt - 1) / shardCnt;
+        auto rangeFirst = [=](const PWP_UINT32 r) {
+            return std::min(edgeCnt, r * rangeSize); };
+        // pos[r * shardCnt + s] is the count and then the next offset of
+        // range r in bucket s
+        std::vector<size_t> pos(size_t(shardCnt) * shardCnt, 0);
+        pool_.parallelFor(shardCnt, [&](const PWP_UINT32 r) {
+            size_t *rPos = pos.data() + size_t(r) * shardCnt;
+            for (PWP_UINT32 ii = rangeFirst(r); ii < rangeFirst(r + 1);
+                    ++ii) {
+                const PWP_UINT32 s0 = edges_[ii].first / shardSize;
+                const PWP_UINT32 s1 = edges_[ii].second / shardSize;
+                ++rPos[s0];
+                if (s1 != s0) {
+                    ++rPos[s1];
+                }
+            }
+        });
+        std::vector<size_t> bucketFirst(size_t(shardCnt) + 1, 0);
+        size_t total = 0;
+        for (PWP_UINT32 s = 0; s < shardCnt; ++s) {
+            bucketFirst[s] = total;
+            for (PWP_UINT32 r = 0; r < shardCnt; ++r) {
+                const size_t cnt = pos[size_t(r) * shardCnt + s];
+                pos[size_t(r) * shardCnt + s] = total;
+                total += cnt;
+            }
+        }
+        bucketFirst[shardCnt] = total;
+
+        // The indices of the edges that touch each shard
+        std::vector<PWP_UINT32> buckets(total);
+        pool_.parallelFor(shardCnt, [&](const PWP_UINT32 r) {
+            size_t *rPos = pos.data() + size_t(r) * shardCnt;
+            for (PWP_UINT32 ii = rangeFirst(r); ii < rangeFirst(r + 1);
+                    ++ii) {
+                const PWP_UINT32 s0 = edges_[ii].first / shardSize;
+                const PWP_UINT32 s1 = edges_[ii].second / shardSize;
+                buckets[rPos[s0]++] = ii;
+                if (s1 != s0) {
+                    buckets[rPos[s1]++] = ii;
+                }
+            }
+        });
+
+        pool_.parallelFor(shardCnt, [&](const PWP_UINT32 s) {
+            const PWP_UINT32 first = std::min(nodeCnt, s * shardSize);
+            pushPts(first, std::min(nodeCnt, first + shardSize),
+                UInt32Span(buckets.data() + bucketFirst[s],
+                    buckets.data() + bucketFirst[s + 1]));
+        });
+    }
+    nodeNbors_.build(nodeCnt, edges_);
+}
+
+
+void
+CaeUnsUMCPSEG::logSizing(const char *what, const size_t expected,
+    const size_t actual)
+{
+    logWritef("# sizing: %s expected %lu actual %lu (%+ld)\n", what,
+        (unsigned long)expected, (unsigned long)actual,
+        long(actual) - long(expected));
+}
+
+
+void
+CaeUnsUMCPSEG::classifyEdge(EdgeRec &rec) const
+{
+    // Called concurrently for different edges. Must not touch model_.
+    MaterialId matId = 0;
+    ZoneId zoneId = UndefinedId;
+    bool mzFromVC = false; // true if matId and zoneId came from a VC
+    bool isGeomEdge = false; // true if edge should be added to geomEdges_
+    if (getEdgeMatAndZone(rec, matId, zoneId, mzFromVC, isGeomEdge)) {
+        rec.matId = matId;
+        rec.zoneId = zoneId;
+        rec.flags = EdgeRec::IsValid;
         if (mzFromVC) {
-            ni.setVCMaterial(matId);
-            ni.setVCZone(zoneId);
+            rec.flags |= EdgeRec::MzFromVC;
         }
-        else {
-            ni.setBCMaterial(matId);
-            ni.setBCZone(zoneId);
+        if (isGeomEdge) {
+            rec.flags |= EdgeRec::IsGeomEdge;
         }
     }
-    return ret;
+}
+
+
+void
+CaeUnsUMCPSEG::pushPts(const PWP_UINT32 first, const PWP_UINT32 last,
+    const UInt32Span &edgeNdxs)
+{
+    // Called concurrently for disjoint node ranges. edgeNdxs holds the edges
+    // that touch the range in stream order.
+    UInt32Span::const_iterator it = edgeNdxs.begin();
+    for (; edgeNdxs.end() != it; ++it) {
+        const PWP_UINT32 ii = *it;
+        const Edge &e = edges_[ii];
+        if (e.first >= first && e.first < last) {
+            pushPt(e.first, edgeRecs_[ii]);
+        }
+        if (e.second >= first && e.second < last) {
+            pushPt(e.second, edgeRecs_[ii]);
+        }
+    }
+}
+
+
+void
+CaeUnsUMCPSEG::pushPt(const PWP_UINT32 vPt, const EdgeRec &rec)
+{
+    if (PWGM_FACETYPE_BOUNDARY == rec.type) {
+        nodeInfo_.setBndry(vPt);
+    }
+    if (0 != (rec.flags & EdgeRec::MzFromVC)) {
+        nodeInfo_.setVCMaterial(vPt, rec.matId);
+        nodeInfo_.setVCZone(vPt, rec.zoneId);
+    }
+    else {
+        nodeInfo_.setBCMaterial(vPt, rec.matId);
+        nodeInfo_.setBCZone(vPt, rec.zoneId);
+    }
 }
 
 
@@ -516,7 +1998,7 @@ CaeUnsUMCPSEG::createBCsAndVCs(CAEP_RTITEM &rti)
     // Generate dynamically generated materials
     for (PWP_INT32 id = 0; id < MaterialCnt; ++id) {
         char phystype[128];
-        sprintf(phystype, "Material-%c", matIdChar(MaterialId(id)));
+        sprintf(phystype, "Material-%c", NlistFormat::matIdChar(int(id)));
         // cache phystype so ptr used below is persistent
         typeNames_.push_back(phystype);
         const char *p = typeNames_.back().c_str();
@@ -545,19 +2027,19 @@ CaeUnsUMCPSEG::createBCsAndVCs(CAEP_RTITEM &rti)
 
 
 bool
-CaeUnsUMCPSEG::getEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
+CaeUnsUMCPSEG::getEdgeMatAndZone(const EdgeRec &rec,
     MaterialId &matId, ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const
 {
     bool ret;
-    switch (data.type) {
+    switch (rec.type) {
     case PWGM_FACETYPE_BOUNDARY:
-        ret = getBndryEdgeMatAndZone(data, matId, zoneId, mzFromVC, isGeomEdge);
+        ret = getBndryEdgeMatAndZone(rec, matId, zoneId, mzFromVC, isGeomEdge);
         break;
     case PWGM_FACETYPE_INTERIOR:
-        ret = getIntorEdgeMatAndZone(data, matId, zoneId, mzFromVC, isGeomEdge);
+        ret = getIntorEdgeMatAndZone(rec, matId, zoneId, mzFromVC, isGeomEdge);
         break;
     case PWGM_FACETYPE_CONNECTION:
-        ret = getCnxnEdgeMatAndZone(data, matId, zoneId, mzFromVC, isGeomEdge);
+        ret = getCnxnEdgeMatAndZone(rec, matId, zoneId, mzFromVC, isGeomEdge);
         break;
     default:
         matId = MatUndefined;
@@ -570,19 +2052,19 @@ CaeUnsUMCPSEG::getEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
 
 
 bool
-CaeUnsUMCPSEG::getBndryEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
+CaeUnsUMCPSEG::getBndryEdgeMatAndZone(const EdgeRec &rec,
     MaterialId &matId, ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const
 {
     bool useVC = true;
-    if (PWGM_HDOMAIN_ISVALID(data.owner.domain)) {
+    if (PWP_UINT32_UNDEF != rec.ownerDom) {
         mzFromVC = false;
-        getMatAndZone(data.owner.domain, matId, zoneId);
+        domConds_.get(rec.ownerDom, matId, zoneId);
         useVC = (MatUndefined == matId || ZoneUndefined == zoneId);
     }
 
     if (useVC) {
         mzFromVC = true;
-        getMatAndZone(data.owner.block, matId, zoneId);
+        blkConds_.get(rec.ownerBlk, matId, zoneId);
     }
 
     isGeomEdge = true; // always
@@ -591,31 +2073,30 @@ CaeUnsUMCPSEG::getBndryEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
 
 
 bool
-CaeUnsUMCPSEG::getIntorEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
+CaeUnsUMCPSEG::getIntorEdgeMatAndZone(const EdgeRec &rec,
     MaterialId &matId, ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const
 {
     bool ret = false;
-    const CaeUnsBlock owner(data.owner.block);
-    CaeUnsBlock nbor;
-    if (!getNborBlk(data, nbor)) {
+    PWP_UINT32 nborBlkId;
+    if (!getNborBlk(rec, nborBlkId)) {
         isGeomEdge = false;
         mzFromVC = false;
         matId = MatUndefined;
         zoneId = ZoneUndefined;
     }
-    else if (owner.index() == nbor.index()) {
+    else if (rec.ownerBlk == nborBlkId) {
         // Same block on both sides. No need to get the neighbor info.
-        getMatAndZone(data.owner.block, matId, zoneId);
+        blkConds_.get(rec.ownerBlk, matId, zoneId);
         mzFromVC = true;
         isGeomEdge = false;
         ret = true;
     }
     else {
         // edge is between different blocks
-        getMatAndZone(data.owner.block, matId, zoneId);
+        blkConds_.get(rec.ownerBlk, matId, zoneId);
         MaterialId nborMatId;
         ZoneId nborZoneId;
-        getMatAndZone(nbor, nborMatId, nborZoneId);
+        blkConds_.get(nborBlkId, nborMatId, nborZoneId);
         isGeomEdge = (nborMatId != matId) || (nborZoneId != zoneId);
         if (isGeomEdge) {
             // edge is between elements with different material and/or zone ids
@@ -640,21 +2121,20 @@ CaeUnsUMCPSEG::getIntorEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
 
 
 bool
-CaeUnsUMCPSEG::getCnxnEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
+CaeUnsUMCPSEG::getCnxnEdgeMatAndZone(const EdgeRec &rec,
     MaterialId &matId, ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const
 {
     // a connection is the same as interior with one or both of:
     //  * different VCs on either side
     //  * member of a non-inflated BC
     // So, first get interior status. If also member of a BC, do more
-    bool ret = getIntorEdgeMatAndZone(data, matId, zoneId, mzFromVC,
+    bool ret = getIntorEdgeMatAndZone(rec, matId, zoneId, mzFromVC,
                 isGeomEdge);
-    const PWGM_HDOMAIN &h = data.owner.domain;
-    if (PWGM_HDOMAIN_ISVALID(h)) {
+    if (PWP_UINT32_UNDEF != rec.ownerDom) {
         // edge is also a member of a non-inflated BC
         MaterialId eMatId;
         ZoneId eZoneId;
-        getMatAndZone(h, eMatId, eZoneId);
+        domConds_.get(rec.ownerDom, eMatId, eZoneId);
         isGeomEdge = isGeomEdge || (eMatId != matId) || (eZoneId != zoneId);
         // BC mat/zone always take precedence over VC mat/zone
         matId = eMatId;
@@ -666,13 +2146,13 @@ CaeUnsUMCPSEG::getCnxnEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
 
 
 bool
-CaeUnsUMCPSEG::getNborBlk(const PWGM_FACESTREAM_DATA &d, CaeUnsBlock &blk) const
+CaeUnsUMCPSEG::getNborBlk(const EdgeRec &rec, PWP_UINT32 &blkId) const
 {
-    PWGM_ENUMELEMDATA eed;
-    const PWGM_HELEMENT hE = PwModEnumElements(d.model, d.neighborCellIndex);
-    return PwElemDataModEnum(hE, &eed)
-        ? blk.moveTo(model_, PWGM_HELEMENT_PID(eed.hBlkElement)).isValid()
-        : false;
+    const bool ret = (rec.nborCell < elemBlk_.size());
+    if (ret) {
+        blkId = elemBlk_[rec.nborCell];
+    }
+    return ret;
 }
 
 
@@ -691,50 +2171,6 @@ CaeUnsUMCPSEG::getMatAndZone(const PWGM_CONDDATA &cd, MaterialId &matId,
 }
 
 
-void
-CaeUnsUMCPSEG::getMatAndZone(const PWGM_HBLOCK &h, MaterialId &matId,
-    ZoneId &zoneId) const
-{
-    if (PWGM_HBLOCK_ID(h) != curBlkId_) {
-        if (CaeUnsBlock(h).condition(curBlkCond_)) {
-            curBlkId_ = PWGM_HBLOCK_ID(h);
-        }
-        else {
-            curBlkId_ = PWP_UINT32_UNDEF;
-        }
-    }
-    if (PWP_UINT32_UNDEF == curBlkId_) {
-        matId = MatUndefined;
-        zoneId = ZoneUndefined;
-    }
-    else {
-        getMatAndZone(curBlkCond_, matId, zoneId);
-    }
-}
-
-
-void
-CaeUnsUMCPSEG::getMatAndZone(const PWGM_HDOMAIN &h, MaterialId &matId,
-    ZoneId &zoneId) const
-{
-    if (PWGM_HDOMAIN_ID(h) != curDomId_) {
-        if (CaeUnsPatch(h).condition(curDomCond_)) {
-            curDomId_ = PWGM_HDOMAIN_ID(h);
-        }
-        else {
-            curDomId_ = PWP_UINT32_UNDEF;
-        }
-    }
-    if (PWP_UINT32_UNDEF == curDomId_) {
-        matId = MatUndefined;
-        zoneId = ZoneUndefined;
-    }
-    else {
-        getMatAndZone(curDomCond_, matId, zoneId);
-    }
-}
-
-
 //===========================================================================
 // called ONCE when plugin first loaded into memory
 //===========================================================================
@@ -748,6 +2184,77 @@ CaeUnsUMCPSEG::create(CAEP_RTITEM &rti)
     ret = ret && publishBoolValueDef(rti, CreateLog, DRVAL(true, false),
             "Controls generation of a log file for debugging.");
 
+    ret = ret && publishEnumValueDef(rti, LogFormat, "Text",
+            "Format of the CreateLog file. Text writes a Tcl script to the "
+            ".log file. Binary writes compact records to the .log.bin file. "
+            "Use nlistlog2tcl to convert it to the Text format.",
+            "Text|Binary");
+
+    ret = ret && publishEnumValueDef(rti, LogLevel, "Full",
+            "Nodes written to the CreateLog file. Summary writes none. "
+            "Conflicts writes nodes with a material or zone conflict. "
+            "Boundary writes boundary nodes. Full writes every node. An "
+            "edge is written if either of its nodes is.",
+            "Summary|Conflicts|Boundary|Full");
+
+    ret = ret && publishStringValueDef(rti, LogMaterials, "",
+            "Only log nodes with these material ids, such as \"1,4-6\". "
+            "Empty for all.");
+
+    ret = ret && publishStringValueDef(rti, LogZones, "",
+            "Only log nodes with these zone ids, such as \"1,4-6\". "
+            "Empty for all.");
+
+    ret = ret && publishStringValueDef(rti, LogNodes, "",
+            "Only log nodes with these 1-based node ids, such as "
+            "\"1000-2000\". Empty for all.");
+
+    ret = ret && publishUIntValueDef(rti, OutputBufferSize, 8,
+            "Size in MB of the buffer used to collect the .nlist output "
+            "before it is written to disk. Also limits the text formatted "
+            "in parallel at one time.", 1, 1024);
+
+    ret = ret && publishUIntValueDef(rti, ThreadCount, 0,
+            "Number of threads used to format the output. Use 0 for one "
+            "thread per processor core.", 0, 256);
+
+    ret = ret && publishEnumValueDef(rti, NeighborOrder, "Stream",
+            "Order of the neighbors of each node. Stream keeps the grid "
+            "model order. Index sorts by vertex index. Angle sorts "
+            "counter-clockwise around the node.", "Stream|Index|Angle");
+
+    ret = ret && publishBoolValueDef(rti, MapOutputFile, true,
+            "Write binary exports through a memory mapping of the output "
+            "file. Falls back to buffered output if mapping fails.");
+
+    // Only the codecs built in are offered
+    std::string codecs("Auto|None");
+    if (StreamCompressor::isAvailable(StreamCompressor::CodecGzip)) {
+        codecs += "|gzip";
+    }
+    if (StreamCompressor::isAvailable(StreamCompressor::CodecZstd)) {
+        codecs += "|zstd";
+    }
+    ret = ret && publishEnumValueDef(rti, Compression, "Auto",
+            "Compresses the output file on a separate thread. Auto "
+            "compresses a .nlist.gz or .nlist.zst export file with its codec "
+            "and leaves any other file uncompressed. None never compresses. "
+            "gzip and zstd always compress, whatever the extension.",
+            codecs.c_str());
+
+    ret = ret && publishBoolValueDef(rti, CreateStats, false,
+            "Writes the time of each export step and counts of the edges, "
+            "neighbors and bytes written as JSON to the .stats.json file "
+            "next to the export file.");
+
+    ret = ret && publishUIntValueDef(rti, ProgressSteps, 100,
+            "Max progress updates sent for each export step.", 1, 100000);
+
+    ret = ret && publishUIntValueDef(rti, ProgressInterval, 250,
+            "Max milliseconds between progress updates. Keeps an export "
+            "responsive to abort during slow steps. Use 0 to only update "
+            "at each ProgressSteps fraction.", 0, 60000);
+
     return ret;
 }
 
@@ -21,20 +21,289 @@
 
 #include "CaePlugin.h"
 #include "CaeUnsGridModel.h"
+#include "NlistBinary.h"
 
+#include<algorithm>
+#include<atomic>
 #include<cassert>
+#include<chrono>
+#include<condition_variable>
+#include<cstdarg>
+#include<cstdint>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<ctime>
+#include<functional>
 #include<list>
-#include<map>
+#include<mutex>
+#include<new>
+#include<string>
+#include<thread>
 #include<utility>
 #include<vector>
 
+#if !defined(WINDOWS)
+#   include<fcntl.h>
+#   include<sys/mman.h>
+#   include<time.h>
+#   include<unistd.h>
+#else
+#   if !defined(NOMINMAX)
+#       define NOMINMAX
+#   endif
+#   include<windows.h>
+#endif
 
-typedef std::vector<PWP_UINT32>             UInt32Array1; 
+#if defined(UMCPSEG_HAVE_ZLIB)
+#   include<zlib.h>
+#endif
+
+#if defined(UMCPSEG_HAVE_ZSTD)
+#   include<zstd.h>
+#endif
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// A monotonic arena for the transient data of one export. Each plugin
+// instance owns one. Memory is handed out from large blocks and is never
+// returned piece by piece. release() frees every block at once. allocate()
+// may be called concurrently. It bumps a pointer in the current block with
+// a compare and swap, and only takes the mutex to start a new block.
+class MonotonicArena {
+public:
+
+    enum {
+        // Size of a shared block. Larger requests get a block of their own.
+        BlockBytes = 4 * 1024 * 1024
+    };
+
+    MonotonicArena() :
+        mutex_(),
+        blocks_(),
+        cur_(0),
+        usedBytes_(0),
+        blockBytes_(0),
+        allocCnt_(0),
+        peakBytes_(0)
+    {
+    }
+
+    ~MonotonicArena()
+    {
+        release();
+    }
+
+    void *  allocate(const size_t bytes, const size_t align) {
+                usedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+                allocCnt_.fetch_add(1, std::memory_order_relaxed);
+                if (bytes >= BlockBytes / 2) {
+                    // keep the rest of the current block for small requests
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return alignUp(newBlock(bytes + align), align);
+                }
+                for (;;) {
+                    Block *blk = cur_.load(std::memory_order_acquire);
+                    if (0 != blk) {
+                        char *p = blk->next.load(std::memory_order_relaxed);
+                        size_t pad = alignPad(p, align);
+                        while (size_t(blk->end - p) >= pad + bytes) {
+                            if (blk->next.compare_exchange_weak(p,
+                                    p + pad + bytes,
+                                    std::memory_order_relaxed)) {
+                                return p + pad;
+                            }
+                            pad = alignPad(p, align);
+                        }
+                    }
+                    // The current block is full. The first thread here
+                    // starts a new one, the others retry in it.
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (blk == cur_.load(std::memory_order_relaxed)) {
+                        char *mem = newBlock(BlockBytes);
+                        Block *newBlk = new (mem) Block;
+                        newBlk->next.store(mem + sizeof(Block),
+                            std::memory_order_relaxed);
+                        newBlk->end = mem + BlockBytes;
+                        cur_.store(newBlk, std::memory_order_release);
+                    }
+                } }
+
+    // Frees all blocks. Every container using the arena must be empty or
+    // never used again. Must not be called concurrently with allocate().
+    void    release() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (size_t ii = 0; ii < blocks_.size(); ++ii) {
+                    ::operator delete(blocks_[ii]);
+                }
+                std::vector<char*>().swap(blocks_);
+                cur_.store(0, std::memory_order_relaxed);
+                usedBytes_.store(0, std::memory_order_relaxed);
+                blockBytes_ = 0;
+                allocCnt_.store(0, std::memory_order_relaxed); }
+
+    // Bytes requested since the last release()
+    size_t  usedBytes() const {
+                return usedBytes_.load(std::memory_order_relaxed); }
+
+    // Bytes held in blocks since the last release(). Nothing is freed
+    // before release(), so this is also the high-water mark of the export.
+    size_t  blockBytes() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return blockBytes_; }
+
+    size_t  blockCount() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return blocks_.size(); }
+
+    size_t  allocCount() const {
+                return allocCnt_.load(std::memory_order_relaxed); }
+
+    // The largest blockBytes() of any export so far
+    size_t  peakBytes() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return peakBytes_; }
+
+private:
+
+    // The header at the start of a shared block. The free part of the block
+    // is [next, end).
+    struct Block {
+        std::atomic<char*>  next;
+        char *              end;
+    };
+
+    // The bytes to skip so p is aligned
+    static size_t alignPad(const char *p, const size_t align) {
+                const size_t rem = size_t(reinterpret_cast<uintptr_t>(p) %
+                    align);
+                return (0 == rem) ? 0 : (align - rem); }
+
+    static char* alignUp(char *p, const size_t align) {
+                return p + alignPad(p, align); }
+
+    // Called with mutex_ locked
+    char*   newBlock(const size_t bytes) {
+                char *blk = static_cast<char*>(::operator new(bytes));
+                blocks_.push_back(blk);
+                blockBytes_ += bytes;
+                peakBytes_ = std::max(peakBytes_, blockBytes_);
+                return blk; }
+
+private:
+
+    // Guards blocks_, blockBytes_ and peakBytes_, and the start of a new
+    // shared block
+    mutable std::mutex  mutex_;
+
+    // Every block allocated since the last release()
+    std::vector<char*>  blocks_;
+
+    // The current shared block or null
+    std::atomic<Block*> cur_;
+
+    std::atomic<size_t> usedBytes_;
+    size_t              blockBytes_;
+    std::atomic<size_t> allocCnt_;
+    size_t              peakBytes_;
+};
+
+
+// A std allocator that allocates from a MonotonicArena. Allocators of the
+// same arena are equal. deallocate() does nothing. A container is bound to
+// its arena when it is constructed:
+//
+//     UInt32Array1 v(arena);
+template<typename T>
+class ArenaAllocator {
+public:
+    typedef T   value_type;
+
+    ArenaAllocator(MonotonicArena &arena) :
+        arena_(&arena)
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) :
+        arena_(other.arena())
+    {
+    }
+
+    T *     allocate(const size_t cnt) {
+                return static_cast<T*>(arena_->allocate(cnt * sizeof(T),
+                    alignof(T))); }
+
+    void    deallocate(T *, const size_t) {
+                }
+
+    MonotonicArena * arena() const {
+                return arena_; }
+
+private:
+
+    MonotonicArena *    arena_;
+};
+
+template<typename T, typename U>
+inline bool
+operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+{
+    return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+inline bool
+operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+{
+    return a.arena() != b.arena();
+}
+
+
+// Frees the memory of v. v stays bound to its allocator.
+template<typename VecT>
+inline void
+releaseArray(VecT &v)
+{
+    VecT(v.get_allocator()).swap(v);
+}
+
+
+// The per-export tables that live until endExport() allocate from the
+// plugin's export arena: the node table, neighbor lists, coordinates,
+// elements, condition tables, geometry edges and face chunk offsets. The
+// transient arrays further down use the heap. The BC and VC info outlives an
+// export and uses the heap.
+typedef std::vector<PWP_UINT32, ArenaAllocator<PWP_UINT32> >  UInt32Array1; 
+typedef std::vector<PWP_INT32, ArenaAllocator<PWP_INT32> >    Int32Array1; 
+typedef std::vector<PWP_UINT8, ArenaAllocator<PWP_UINT8> >    UInt8Array1; 
+typedef std::vector<PWP_INT8, ArenaAllocator<PWP_INT8> >      Int8Array1; 
+typedef std::vector<PWP_REAL, ArenaAllocator<PWP_REAL> >      RealArray1; 
+typedef std::vector<size_t, ArenaAllocator<size_t> >          SizeArray1; 
 typedef std::vector<CAEP_BCINFO>            BcInfoArray1; 
 typedef std::vector<CAEP_VCINFO>            VcInfoArray1; 
 typedef std::list<std::string>              StdStringCache; 
 typedef std::pair<PWP_UINT32, PWP_UINT32>   Edge;
-typedef std::vector<Edge>                   EdgeArray1; 
+typedef std::vector<Edge, ArenaAllocator<Edge> >              EdgeArray1; 
+
+// The face stream arrays use the heap, not the export arena. They are all
+// released by the end of init(), before the output is formatted, while the
+// arena would hold their memory until endExport().
+typedef std::vector<PWP_UINT32>             StreamUInt32Array1;
+typedef std::vector<PWP_UINT8>              StreamUInt8Array1;
+typedef std::vector<Edge>                   StreamEdgeArray1;
+
+// Per-chunk scratch space. Uses the heap for the same reason.
+typedef std::vector<double>                 ScratchDoubleArray1;
+
+// The output and formatting buffers use the heap. They grow and are swapped
+// between owners, and the arena would keep every outgrown block until
+// endExport().
+typedef std::vector<char>                   BufferCharArray1;
+
 typedef PWP_INT32                           IdType;
 typedef IdType                              MaterialId;
 typedef IdType                              ZoneId;
@@ -49,11 +318,201 @@ const ZoneId        ZoneUndefined = UndefinedId;
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
+// A fixed set of worker threads that runs parallel loops. The workers are
+// started once per export (start()) and wait between loops, so a loop only
+// costs a wake up instead of a thread spawn. The calling thread always takes
+// part in a loop, so start(n) runs n - 1 workers. Loops must not be nested
+// or run from more than one thread at a time.
+class WorkerPool {
+public:
+
+    WorkerPool() :
+        workers_(),
+        mutex_(),
+        wake_(),
+        idle_(),
+        job_(0),
+        jobId_(0),
+        tickets_(0),
+        busyCnt_(0),
+        isStopping_(false)
+    {
+    }
+
+    ~WorkerPool()
+    {
+        stop();
+    }
+
+    // Starts numThreads - 1 workers. Stops the current workers first.
+    void    start(const PWP_UINT32 numThreads) {
+                stop();
+                isStopping_ = false;
+                for (PWP_UINT32 ii = 1; ii < numThreads; ++ii) {
+                    workers_.push_back(std::thread(&WorkerPool::run, this));
+                } }
+
+    // Joins the workers. Loops run on the calling thread until the next
+    // start().
+    void    stop() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    isStopping_ = true;
+                }
+                wake_.notify_all();
+                for (size_t ii = 0; ii < workers_.size(); ++ii) {
+                    workers_[ii].join();
+                }
+                workers_.clear(); }
+
+    // The number of threads a loop runs on (the workers and the caller)
+    PWP_UINT32 threadCount() const {
+                return PWP_UINT32(workers_.size()) + 1; }
+
+    // Calls func(ndx) once for every ndx in [0, cnt). The ndx values are
+    // handed out in increasing order to whichever thread is free. Returns
+    // when all calls are done. func must be safe to call concurrently.
+    template<typename Func>
+    void    parallelFor(const PWP_UINT32 cnt, const Func &func) {
+                std::atomic<PWP_UINT32> next(0);
+                const Job work = [&]() {
+                    PWP_UINT32 ndx;
+                    while ((ndx = next++) < cnt) {
+                        func(ndx);
+                    }
+                };
+                const PWP_UINT32 numHelpers = dispatch(work, cnt);
+                work();
+                wait(numHelpers); }
+
+    // Same as parallelFor() but the calling thread calls poll(doneCnt) after
+    // each of its own func() calls and once more after all threads are done.
+    // doneCnt is the number of func() calls completed by all threads. Once
+    // poll() returns false no more ndx values are handed out. Returns false
+    // if poll() returned false.
+    template<typename Func, typename PollFunc>
+    bool    parallelForPolled(const PWP_UINT32 cnt, const Func &func,
+                const PollFunc &poll) {
+                std::atomic<PWP_UINT32> next(0);
+                std::atomic<PWP_UINT32> done(0);
+                std::atomic<bool> isStopped(false);
+                const Job work = [&]() {
+                    PWP_UINT32 ndx;
+                    while (!isStopped && (ndx = next++) < cnt) {
+                        func(ndx);
+                        ++done;
+                    }
+                };
+                const PWP_UINT32 numHelpers = dispatch(work, cnt);
+                bool ret = true;
+                PWP_UINT32 ndx;
+                while (ret && (ndx = next++) < cnt) {
+                    func(ndx);
+                    ++done;
+                    ret = poll(PWP_UINT32(done));
+                }
+                isStopped = !ret;
+                wait(numHelpers);
+                return ret && poll(PWP_UINT32(done)); }
+
+private:
+
+    typedef std::function<void()>   Job;
+
+    // Hands job to up to cnt - 1 workers. Returns the number of workers that
+    // will run it.
+    PWP_UINT32 dispatch(const Job &job, const PWP_UINT32 cnt) {
+                const PWP_UINT32 numHelpers = (0 == cnt) ? 0 :
+                    std::min(PWP_UINT32(workers_.size()), cnt - 1);
+                if (numHelpers > 0) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        job_ = &job;
+                        ++jobId_;
+                        tickets_ = numHelpers;
+                        busyCnt_ = numHelpers;
+                    }
+                    wake_.notify_all();
+                }
+                return numHelpers; }
+
+    // Blocks until the numHelpers workers of the current job are done
+    void    wait(const PWP_UINT32 numHelpers) {
+                if (numHelpers > 0) {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    idle_.wait(lock, [this] { return 0 == busyCnt_; });
+                    job_ = 0;
+                } }
+
+    // The worker thread function. A worker runs each job at most once and
+    // only while tickets are left.
+    void    run() {
+                PWP_UINT64 seenId = 0;
+                std::unique_lock<std::mutex> lock(mutex_);
+                for (;;) {
+                    wake_.wait(lock, [&] {
+                        return isStopping_ || seenId != jobId_; });
+                    if (isStopping_) {
+                        break;
+                    }
+                    seenId = jobId_;
+                    if (0 == tickets_) {
+                        continue;
+                    }
+                    --tickets_;
+                    const Job *job = job_;
+                    lock.unlock();
+                    (*job)();
+                    lock.lock();
+                    if (0 == --busyCnt_) {
+                        idle_.notify_one();
+                    }
+                } }
+
+private:
+
+    // The worker threads
+    std::vector<std::thread> workers_;
+
+    // Guards job_, jobId_, tickets_, busyCnt_ and isStopping_
+    std::mutex          mutex_;
+
+    // Signals a new job or stop() to the workers
+    std::condition_variable wake_;
+
+    // Signals busyCnt_ reaching 0 to the calling thread
+    std::condition_variable idle_;
+
+    // The current job. Lives on the stack of the calling thread.
+    const Job *         job_;
+
+    // Incremented for each job so a worker runs it at most once
+    PWP_UINT64          jobId_;
+
+    // The number of workers that may still take the current job
+    PWP_UINT32          tickets_;
+
+    // The number of workers that took the current job and are not done
+    PWP_UINT32          busyCnt_;
+
+    // Set by stop()
+    bool                isStopping_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Manages an id value stored in an external slot. The conflict state is
+// stored as a bit in an external flags value.
+template<typename IdT, typename FlagsT>
 class ManagedId {
 public:
-    ManagedId() :
-        id_(UndefinedId),
-        hadConflict_(false)
+    ManagedId(IdT &id, FlagsT &flags, const PWP_UINT8 conflictBit) :
+        id_(id),
+        flags_(flags),
+        conflictBit_(conflictBit)
     {
     }
 
@@ -69,35 +528,36 @@ public:
         }
         else if (UndefinedId == id_) {
             // Capture first valid id - no conflict here!
-            id_ = id;
+            id_ = IdT(id);
         }
         else if (id == id_) {
             // incoming id is same as already captured id_ - no conflict here!
         }
         else { // id != id_
-            hadConflict_ = true;
+            flags_ |= conflictBit_;
             if (id > id_) {
                 // capture larger incoming id value
-                id_ = id;
+                id_ = IdT(id);
             }
         }
     }
 
     IdType getId() const
     {
-        return id_;
+        return IdType(id_);
     }
 
     bool isSet(IdType &id, bool &hadConflict) const
     {
-        hadConflict = hadConflict_;
-        return UndefinedId != (id = id_);
+        hadConflict = (0 != (flags_ & conflictBit_));
+        return UndefinedId != (id = IdType(id_));
     }
 
 private:
 
-    IdType  id_;
-    bool    hadConflict_;
+    IdT &           id_;
+    FlagsT &        flags_;
+    const PWP_UINT8 conflictBit_;
 };
 
 
@@ -105,61 +565,107 @@ private:
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
-class NodeInfo {
+// The material, zone and boundary state of every node indexed by vertex index.
+// The state is stored as parallel arrays. The boundary flag and the conflict
+// flag of each ManagedId are packed into a single flags byte per node.
+class NodeTable {
 public:
 
-    NodeInfo() :
-        isBndry_(false),
-        elemMaterial_(),
-        edgeMaterial_(),
-        elemZone_(),
-        edgeZone_(),
-        nbors_()
+    explicit NodeTable(MonotonicArena &arena) :
+        flags_(arena),
+        elemMaterial_(arena),
+        edgeMaterial_(arena),
+        elemZone_(arena),
+        edgeZone_(arena)
     {
     }
 
-    ~NodeInfo()
+    ~NodeTable()
     {
     }
 
-    UInt32Array1&       nbors() {
-                            return nbors_; }
-
-    const UInt32Array1& nbors() const {
-                            return nbors_; }
-
-    PWP_UINT32          nborCount() const {
-                            return PWP_UINT32(nbors_.size()); }
-
-    MaterialId  getMaterial(bool &hadConflict) const {
-                    return evalIds(elemMaterial_, edgeMaterial_, hadConflict); }
-
-    void        setVCMaterial(const MaterialId id) {
-                    elemMaterial_.setId(id); }
-
-    void        setBCMaterial(const MaterialId id) {
-                    edgeMaterial_.setId(id); }
-
-    ZoneId      getZone(bool &hadConflict) const {
-                    return evalIds(elemZone_, edgeZone_, hadConflict); }
-
-    void        setVCZone(const MaterialId id) {
-                    elemZone_.setId(id); }
-
-    void        setBCZone(const MaterialId id) {
-                    edgeZone_.setId(id); }
-
-    bool        isBndry() const {
-                    return isBndry_; }
-
-    void        setBndry() {
-                    isBndry_ = true; }
+    // Sizes the table to cnt nodes. All ids are undefined and all flags are
+    // cleared.
+    void        resize(const PWP_UINT32 cnt) {
+                    flags_.assign(cnt, 0);
+                    elemMaterial_.assign(cnt, PWP_INT8(MatUndefined));
+                    edgeMaterial_.assign(cnt, PWP_INT8(MatUndefined));
+                    elemZone_.assign(cnt, ZoneUndefined);
+                    edgeZone_.assign(cnt, ZoneUndefined); }
+
+    void        clear() {
+                    releaseArray(flags_);
+                    releaseArray(elemMaterial_);
+                    releaseArray(edgeMaterial_);
+                    releaseArray(elemZone_);
+                    releaseArray(edgeZone_); }
+
+    PWP_UINT32  size() const {
+                    return PWP_UINT32(flags_.size()); }
+
+    MaterialId  getMaterial(const PWP_UINT32 ndx, bool &hadConflict) const {
+                    return evalIds(
+                        CMatId(elemMaterial_[ndx], flags_[ndx], ElemMatConf),
+                        CMatId(edgeMaterial_[ndx], flags_[ndx], EdgeMatConf),
+                        hadConflict); }
+
+    void        setVCMaterial(const PWP_UINT32 ndx, const MaterialId id) {
+                    assert(isNarrowMaterial(id));
+                    MatId(elemMaterial_[ndx], flags_[ndx],
+                        ElemMatConf).setId(id); }
+
+    void        setBCMaterial(const PWP_UINT32 ndx, const MaterialId id) {
+                    assert(isNarrowMaterial(id));
+                    MatId(edgeMaterial_[ndx], flags_[ndx],
+                        EdgeMatConf).setId(id); }
+
+    ZoneId      getZone(const PWP_UINT32 ndx, bool &hadConflict) const {
+                    return evalIds(
+                        CZnId(elemZone_[ndx], flags_[ndx], ElemZoneConf),
+                        CZnId(edgeZone_[ndx], flags_[ndx], EdgeZoneConf),
+                        hadConflict); }
+
+    void        setVCZone(const PWP_UINT32 ndx, const ZoneId id) {
+                    ZnId(elemZone_[ndx], flags_[ndx], ElemZoneConf).setId(id); }
+
+    void        setBCZone(const PWP_UINT32 ndx, const ZoneId id) {
+                    ZnId(edgeZone_[ndx], flags_[ndx], EdgeZoneConf).setId(id); }
+
+    bool        isBndry(const PWP_UINT32 ndx) const {
+                    return 0 != (flags_[ndx] & Bndry); }
+
+    void        setBndry(const PWP_UINT32 ndx) {
+                    flags_[ndx] |= Bndry; }
+
+    // Returns true if id fits the narrow material arrays. Material ids are
+    // in the range 0..35 (see createBCsAndVCs()). buildCondTables() rejects
+    // any other id, so a stored id is never truncated.
+    static bool isNarrowMaterial(const MaterialId id) {
+                    return (MatUndefined == id) || ((id >= -128) &&
+                        (id <= 127)); }
 
 
 private:
 
-    IdType evalIds(const ManagedId &elem, const ManagedId &edge,
-        bool &hadConf) const
+    // Material ids are stored as PWP_INT8 (see isNarrowMaterial()). Zone ids
+    // are user assigned and are stored as-is.
+    typedef ManagedId<PWP_INT8, PWP_UINT8>              MatId;
+    typedef ManagedId<const PWP_INT8, const PWP_UINT8>  CMatId;
+    typedef ManagedId<PWP_INT32, PWP_UINT8>             ZnId;
+    typedef ManagedId<const PWP_INT32, const PWP_UINT8> CZnId;
+
+    // flags_ bits
+    enum {
+        Bndry           = 0x01,
+        ElemMatConf     = 0x02,
+        EdgeMatConf     = 0x04,
+        ElemZoneConf    = 0x08,
+        EdgeZoneConf    = 0x10
+    };
+
+    template<typename ElemIdT, typename EdgeIdT>
+    static IdType evalIds(const ElemIdT &elem, const EdgeIdT &edge,
+        bool &hadConf)
     {
         IdType ret;
         if (edge.isSet(ret, hadConf)) {
@@ -180,20 +686,1444 @@ private:
 
 private:
 
-    bool            isBndry_;
-    ManagedId       elemMaterial_;
-    ManagedId       edgeMaterial_;
-    ManagedId       elemZone_;
-    ManagedId       edgeZone_;
+    // Bndry and ManagedId conflict bits of each node
+    UInt8Array1     flags_;
+    Int8Array1      elemMaterial_;
+    Int8Array1      edgeMaterial_;
+    Int32Array1     elemZone_;
+    Int32Array1     edgeZone_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Read-only view of a contiguous run of PWP_UINT32 values.
+class UInt32Span {
+public:
+    typedef const PWP_UINT32 *  const_iterator;
+
+    UInt32Span(const_iterator begin = 0, const_iterator end = 0) :
+        begin_(begin),
+        end_(end)
+    {
+    }
+
+    const_iterator  begin() const {
+                        return begin_; }
+
+    const_iterator  end() const {
+                        return end_; }
+
+    PWP_UINT32      size() const {
+                        return PWP_UINT32(end_ - begin_); }
+
+    PWP_UINT32      operator[](const PWP_UINT32 ndx) const {
+                        return begin_[ndx]; }
+
+private:
+
+    const_iterator  begin_;
+    const_iterator  end_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The neighbor nodes of every node stored in compressed sparse row (CSR)
+// form. The neighbors of node ndx are nbors_[offsets_[ndx]..offsets_[ndx+1]).
+class NodeNbors {
+public:
+    explicit NodeNbors(MonotonicArena &arena) :
+        offsets_(arena),
+        nbors_(arena)
+    {
+    }
+
+    ~NodeNbors()
+    {
+    }
+
+    // Builds the CSR arrays from edges. Each edge adds its second node to the
+    // neighbors of its first node and vice versa. The neighbors of each node
+    // are stored in the same order as the edges array.
+    void build(const PWP_UINT32 nodeCnt, const StreamEdgeArray1 &edges)
+    {
+        // count the neighbors of each node into offsets_[ndx + 1]
+        offsets_.assign(nodeCnt + 1, 0);
+        StreamEdgeArray1::const_iterator it;
+        for (it = edges.begin(); edges.end() != it; ++it) {
+            assert(it->first < nodeCnt && it->second < nodeCnt);
+            ++offsets_[it->first + 1];
+            ++offsets_[it->second + 1];
+        }
+
+        // offsets_[ndx] becomes the start of node ndx's neighbors
+        for (PWP_UINT32 ndx = 1; ndx <= nodeCnt; ++ndx) {
+            offsets_[ndx] += offsets_[ndx - 1];
+        }
+
+        // Fill the neighbors using offsets_[ndx] as node ndx's insert cursor.
+        // When done, offsets_[ndx] is the start of node ndx + 1.
+        nbors_.resize(offsets_[nodeCnt]);
+        for (it = edges.begin(); edges.end() != it; ++it) {
+            nbors_[offsets_[it->first]++] = it->second;
+            nbors_[offsets_[it->second]++] = it->first;
+        }
+
+        // shift the cursors back to the node starts
+        for (PWP_UINT32 ndx = nodeCnt; ndx > 0; --ndx) {
+            offsets_[ndx] = offsets_[ndx - 1];
+        }
+        offsets_[0] = 0;
+    }
+
+    // Sorts the neighbors of each node first..last-1 by increasing index
+    void sortByIndex(const PWP_UINT32 first, const PWP_UINT32 last)
+    {
+        for (PWP_UINT32 ndx = first; ndx < last; ++ndx) {
+            PWP_UINT32 * const v = nbors_.data() + offsets_[ndx];
+            const PWP_UINT32 cnt = offsets_[ndx + 1] - offsets_[ndx];
+            if (cnt <= NetworkSortMax) {
+                // odd-even transposition network of branchless swaps
+                for (PWP_UINT32 pass = 0; pass < cnt; ++pass) {
+                    for (PWP_UINT32 ii = pass & 1; ii + 1 < cnt; ii += 2) {
+                        const PWP_UINT32 lo = std::min(v[ii], v[ii + 1]);
+                        v[ii + 1] = std::max(v[ii], v[ii + 1]);
+                        v[ii] = lo;
+                    }
+                }
+            }
+            else {
+                std::sort(v, v + cnt);
+            }
+        }
+    }
+
+    // Sorts the neighbors of each node first..last-1 by increasing
+    // key(ndx, nbor). Equal keys are ordered by increasing neighbor index, so
+    // the result does not depend on the order of the edges. The keys of a
+    // node are kept in keys, side by side with its neighbors in nbors_.
+    // keys is reused from one node to the next.
+    template<typename KeyFunc>
+    void sortByKey(const PWP_UINT32 first, const PWP_UINT32 last,
+        const KeyFunc &key, ScratchDoubleArray1 &keys)
+    {
+        for (PWP_UINT32 ndx = first; ndx < last; ++ndx) {
+            PWP_UINT32 * const v = nbors_.data() + offsets_[ndx];
+            const PWP_UINT32 cnt = offsets_[ndx + 1] - offsets_[ndx];
+            if (keys.size() < cnt) {
+                keys.resize(cnt);
+            }
+            double * const k = keys.data();
+            for (PWP_UINT32 ii = 0; ii < cnt; ++ii) {
+                k[ii] = key(ndx, v[ii]);
+            }
+            if (cnt <= NetworkSortMax) {
+                for (PWP_UINT32 pass = 0; pass < cnt; ++pass) {
+                    for (PWP_UINT32 ii = pass & 1; ii + 1 < cnt; ii += 2) {
+                        keySwap(k, v, ii, ii + 1);
+                    }
+                }
+            }
+            else {
+                // insertion sort. Only a few nodes have this many neighbors.
+                for (PWP_UINT32 ii = 1; ii < cnt; ++ii) {
+                    for (PWP_UINT32 jj = ii; jj > 0 && k[jj] < k[jj - 1];
+                            --jj) {
+                        std::swap(k[jj], k[jj - 1]);
+                        std::swap(v[jj], v[jj - 1]);
+                    }
+                }
+            }
+            // equal keys are rare
+            for (PWP_UINT32 ii = 1; ii < cnt; ++ii) {
+                if (k[ii] == k[ii - 1]) {
+                    fixTies(k, v, cnt);
+                    break;
+                }
+            }
+        }
+    }
+
+    void        clear() {
+                    releaseArray(offsets_);
+                    releaseArray(nbors_); }
+
+    UInt32Span  nbors(const PWP_UINT32 ndx) const {
+                    const PWP_UINT32 *p = nbors_.data();
+                    return UInt32Span(p + offsets_[ndx],
+                        p + offsets_[ndx + 1]); }
+
+    PWP_UINT32  nborCount(const PWP_UINT32 ndx) const {
+                    return offsets_[ndx + 1] - offsets_[ndx]; }
+
+    // The total number of neighbors of nodes first..last-1
+    PWP_UINT32  nborTotal(const PWP_UINT32 first,
+                    const PWP_UINT32 last) const {
+                    return offsets_[last] - offsets_[first]; }
+
+    PWP_UINT32  nodeCount() const {
+                    return offsets_.empty() ? 0 :
+                        PWP_UINT32(offsets_.size() - 1); }
+
+private:
+
+    enum {
+        // The largest neighbor count sorted with a sorting network
+        NetworkSortMax = 8
+    };
+
+    // Orders entries a < b of the k and v arrays by key alone. The keys take
+    // min/max and the neighbors an xor swap under a mask, so there is no
+    // branch to mispredict.
+    static void keySwap(double *k, PWP_UINT32 *v, const PWP_UINT32 a,
+        const PWP_UINT32 b)
+    {
+        const PWP_UINT32 mask = 0u - PWP_UINT32(k[b] < k[a]);
+        const PWP_UINT32 diff = (v[a] ^ v[b]) & mask;
+        const double lo = std::min(k[a], k[b]);
+        k[b] = std::max(k[a], k[b]);
+        k[a] = lo;
+        v[a] ^= diff;
+        v[b] ^= diff;
+    }
+
+    // Orders the runs of equal keys of the key sorted k and v arrays by
+    // increasing neighbor index
+    static void fixTies(const double *k, PWP_UINT32 *v, const PWP_UINT32 cnt)
+    {
+        PWP_UINT32 runBeg = 0;
+        for (PWP_UINT32 ii = 1; ii <= cnt; ++ii) {
+            if (ii == cnt || k[ii] != k[runBeg]) {
+                std::sort(v + runBeg, v + ii);
+                runBeg = ii;
+            }
+        }
+    }
+
+private:
+
+    // The start of each node's neighbors in nbors_ (size is nodeCount + 1)
+    UInt32Array1    offsets_;
+
+    // The neighbors of all nodes
     UInt32Array1    nbors_;
 };
 
 
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Compresses a stream of buffers on a worker thread and writes the result to
+// a PwpFile. push() hands a full buffer to the worker and returns while it
+// is compressed. Codecs are only available when their build flag is defined
+// (UMCPSEG_HAVE_ZLIB links zlib, UMCPSEG_HAVE_ZSTD links libzstd).
+class StreamCompressor {
+public:
+
+    enum Codec {
+        CodecNone,
+        CodecGzip,
+        CodecZstd
+    };
+
+    enum {
+        // Fast levels. The output is fixed-width text that compresses well.
+        GzipLevel = 1,
+        ZstdLevel = 3,
+        // Size of the compressed output buffer
+        OutBufferBytes = 1024 * 1024
+    };
+
+    StreamCompressor() :
+        file_(0),
+        codec_(CodecNone),
+        thread_(),
+        mutex_(),
+        cond_(),
+        pending_(),
+        pendingCnt_(0),
+        hasPending_(false),
+        isDone_(false),
+        isOk_(true),
+        outBuf_()
+#if defined(UMCPSEG_HAVE_ZSTD)
+        , zstd_(0)
+#endif
+    {
+    }
+
+    ~StreamCompressor()
+    {
+        finish();
+    }
+
+    static bool isAvailable(const Codec codec) {
+                switch (codec) {
+                case CodecNone: return true;
+#if defined(UMCPSEG_HAVE_ZLIB)
+                case CodecGzip: return true;
+#endif
+#if defined(UMCPSEG_HAVE_ZSTD)
+                case CodecZstd: return true;
+#endif
+                default:        break;
+                }
+                return false; }
+
+    // Starts the worker thread. Returns false if codec is not available.
+    bool    start(PwpFile &file, const Codec codec) {
+                finish();
+                bool ret = false;
+                switch (codec) {
+#if defined(UMCPSEG_HAVE_ZLIB)
+                case CodecGzip:
+                    memset(&zlib_, 0, sizeof(zlib_));
+                    // 15 + 16 selects the gzip wrapper
+                    ret = (Z_OK == deflateInit2(&zlib_, GzipLevel, Z_DEFLATED,
+                        15 + 16, 8, Z_DEFAULT_STRATEGY));
+                    break;
+#endif
+#if defined(UMCPSEG_HAVE_ZSTD)
+                case CodecZstd:
+                    zstd_ = ZSTD_createCCtx();
+                    ret = (0 != zstd_) && !ZSTD_isError(ZSTD_CCtx_setParameter(
+                        zstd_, ZSTD_c_compressionLevel, ZstdLevel));
+                    break;
+#endif
+                default:
+                    break;
+                }
+                if (ret) {
+                    file_ = &file;
+                    codec_ = codec;
+                    hasPending_ = false;
+                    isDone_ = false;
+                    isOk_ = true;
+                    outBuf_.resize(OutBufferBytes);
+                    thread_ = std::thread(&StreamCompressor::run, this);
+                }
+                return ret; }
+
+    bool    isStarted() const {
+                return thread_.joinable(); }
+
+    // Queues the first cnt chars of buf for compression. buf is swapped
+    // with a free buffer of unspecified size. Blocks while the worker still
+    // has a previous buffer queued. Returns false if compression or writing
+    // has failed.
+    bool    push(BufferCharArray1 &buf, const size_t cnt) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cond_.wait(lock, [this] { return !hasPending_; });
+                    pending_.swap(buf);
+                    pendingCnt_ = cnt;
+                    hasPending_ = true;
+                }
+                cond_.notify_all();
+                return isOk_; }
+
+    // Compresses all queued data, ends the compressed stream and stops the
+    // worker. Returns false if compression or writing failed.
+    bool    finish() {
+                if (!thread_.joinable()) {
+                    return isOk_;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    isDone_ = true;
+                }
+                cond_.notify_all();
+                thread_.join();
+#if defined(UMCPSEG_HAVE_ZLIB)
+                if (CodecGzip == codec_) {
+                    deflateEnd(&zlib_);
+                }
+#endif
+#if defined(UMCPSEG_HAVE_ZSTD)
+                if (CodecZstd == codec_) {
+                    ZSTD_freeCCtx(zstd_);
+                    zstd_ = 0;
+                }
+#endif
+                codec_ = CodecNone;
+                file_ = 0;
+                BufferCharArray1().swap(pending_);
+                BufferCharArray1().swap(outBuf_);
+                return isOk_; }
+
+private:
+
+    // The worker loop
+    void    run() {
+                BufferCharArray1 work;
+                for (;;) {
+                    size_t cnt = 0;
+                    bool isLast = false;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cond_.wait(lock, [this] {
+                            return hasPending_ || isDone_; });
+                        if (hasPending_) {
+                            work.swap(pending_);
+                            cnt = pendingCnt_;
+                            hasPending_ = false;
+                        }
+                        else {
+                            isLast = true;
+                        }
+                    }
+                    cond_.notify_all();
+                    if (isOk_) {
+                        isOk_ = encode(work.data(), cnt, isLast);
+                    }
+                    if (isLast) {
+                        break;
+                    }
+                } }
+
+    // Compresses cnt chars of data and writes the compressed output. Ends
+    // the compressed stream if isLast.
+    bool    encode(const char *data, const size_t cnt, const bool isLast) {
+                bool ret = false;
+                switch (codec_) {
+#if defined(UMCPSEG_HAVE_ZLIB)
+                case CodecGzip: {
+                    // zlib counts are uInt. Feed large buffers in pieces.
+                    const size_t maxIn = 1u << 30;
+                    size_t done = 0;
+                    ret = true;
+                    do {
+                        const size_t inCnt = std::min(maxIn, cnt - done);
+                        const bool isEnd = isLast && (done + inCnt == cnt);
+                        zlib_.next_in = reinterpret_cast<Bytef*>(
+                            const_cast<char*>(data + done));
+                        zlib_.avail_in = uInt(inCnt);
+                        int zret;
+                        do {
+                            zlib_.next_out = reinterpret_cast<Bytef*>(
+                                outBuf_.data());
+                            zlib_.avail_out = uInt(outBuf_.size());
+                            zret = deflate(&zlib_, isEnd ? Z_FINISH :
+                                Z_NO_FLUSH);
+                            ret = (Z_STREAM_ERROR != zret) &&
+                                writeOut(outBuf_.size() - zlib_.avail_out);
+                        } while (ret && 0 == zlib_.avail_out);
+                        ret = ret && (!isEnd || Z_STREAM_END == zret);
+                        done += inCnt;
+                    } while (ret && done < cnt);
+                    break; }
+#endif
+#if defined(UMCPSEG_HAVE_ZSTD)
+                case CodecZstd: {
+                    ZSTD_inBuffer in = { data, cnt, 0 };
+                    const ZSTD_EndDirective mode = isLast ? ZSTD_e_end :
+                        ZSTD_e_continue;
+                    ret = true;
+                    for (;;) {
+                        ZSTD_outBuffer out = { outBuf_.data(),
+                            outBuf_.size(), 0 };
+                        const size_t remain = ZSTD_compressStream2(zstd_,
+                            &out, &in, mode);
+                        ret = !ZSTD_isError(remain) && writeOut(out.pos);
+                        if (!ret || (isLast ? (0 == remain) :
+                                (in.pos == in.size))) {
+                            break;
+                        }
+                    }
+                    break; }
+#endif
+                default:
+                    (void)data;
+                    (void)cnt;
+                    (void)isLast;
+                    break;
+                }
+                return ret; }
+
+    // Writes the first cnt chars of outBuf_ to file_
+    bool    writeOut(const size_t cnt) {
+                return (0 == cnt) || (cnt == file_->write(
+                    static_cast<const void*>(outBuf_.data()), 1, cnt)); }
+
+private:
+
+    // The destination file. Only written by the worker thread.
+    PwpFile *           file_;
+
+    // The active codec
+    Codec               codec_;
+
+    // The worker thread
+    std::thread         thread_;
+
+    // Guards pending_, pendingCnt_, hasPending_ and isDone_
+    std::mutex          mutex_;
+
+    // Signals changes to hasPending_ and isDone_
+    std::condition_variable cond_;
+
+    // The buffer queued for the worker. Only the first pendingCnt_ chars
+    // are valid.
+    BufferCharArray1    pending_;
+    size_t              pendingCnt_;
+    bool                hasPending_;
+
+    // Set by finish() to end the compressed stream
+    bool                isDone_;
+
+    // false if compression or writing failed
+    std::atomic<bool>   isOk_;
+
+    // The compressed output buffer. Only used by the worker thread.
+    BufferCharArray1    outBuf_;
+
+#if defined(UMCPSEG_HAVE_ZLIB)
+    // The gzip stream state
+    z_stream            zlib_;
+#endif
+
+#if defined(UMCPSEG_HAVE_ZSTD)
+    // The zstd stream state
+    ZSTD_CCtx *         zstd_;
+#endif
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Collects formatted output in a large memory buffer and writes it to a
+// PwpFile in big blocks. If a started StreamCompressor is given, the blocks
+// are compressed on its thread instead. Text is added with reserve() and
+// commit():
+//
+//     char *p = out.reserve(maxChars);
+//     ...write at most maxChars chars to p, advancing p...
+//     out.commit(p);
+//
+// The buffer is NOT flushed by the destructor. Call flush() when done.
+class BufferedFile {
+public:
+    BufferedFile() :
+        file_(0),
+        zip_(0),
+        buf_(),
+        used_(0),
+        capacity_(0),
+        flushedBytes_(0),
+        isOk_(true)
+    {
+    }
+
+    ~BufferedFile()
+    {
+    }
+
+    // Sends all future output to file using a buffer of capacity chars
+    void    attach(PwpFile &file, const size_t capacity,
+                StreamCompressor *zip = 0) {
+                file_ = &file;
+                zip_ = zip;
+                capacity_ = capacity;
+                buf_.resize(capacity);
+                used_ = 0;
+                flushedBytes_ = 0;
+                isOk_ = true; }
+
+    // Flushes any pending output and releases the buffer
+    bool    detach() {
+                bool ret = flush();
+                if (0 != zip_) {
+                    ret = zip_->finish() && ret;
+                }
+                BufferCharArray1().swap(buf_);
+                file_ = 0;
+                zip_ = 0;
+                return ret; }
+
+    bool    write(const char *buf, const size_t cnt) {
+                char *p = reserve(cnt);
+                memcpy(p, buf, cnt);
+                commit(p + cnt);
+                return isOk_; }
+
+    // Returns a pointer to at least cnt writable chars. A cnt larger than
+    // capacity() grows the buffer until the next flush().
+    char*   reserve(const size_t cnt) {
+                if (buf_.size() - used_ < cnt) {
+                    flush();
+                    if (buf_.size() < cnt) {
+                        // rare - larger than the whole buffer
+                        buf_.resize(cnt);
+                    }
+                }
+                return buf_.data() + used_; }
+
+    // The buffer size given to attach()
+    size_t  capacity() const {
+                return capacity_; }
+
+    // Marks all chars up to end as written. end must be a pointer returned
+    // by reserve() advanced by the number of chars written.
+    void    commit(const char *end) {
+                used_ = size_t(end - buf_.data());
+                assert(used_ <= buf_.size());
+                if (used_ >= capacity_) {
+                    flush();
+                } }
+
+    bool    write(const char *str) {
+                const size_t len = strlen(str);
+                char *p = reserve(len);
+                memcpy(p, str, len);
+                commit(p + len);
+                return isOk_; }
+
+    bool    writef(const char *fmt, ...) {
+                va_list args;
+                va_start(args, fmt);
+                char buf[1024];
+                const int len = vsnprintf(buf, sizeof(buf), fmt, args);
+                va_end(args);
+                return (len >= 0) && (size_t(len) < sizeof(buf)) &&
+                    write(buf); }
+
+    // Writes all buffered output to the file. Returns false if any write
+    // failed since attach().
+    bool    flush() {
+                flushedBytes_ += used_;
+                if (0 == used_) {
+                    // nothing to write
+                }
+                else if (0 != zip_) {
+                    isOk_ = isOk_ && zip_->push(buf_, used_);
+                    used_ = 0;
+                    if (buf_.size() < capacity_) {
+                        buf_.resize(capacity_);
+                    }
+                }
+                else {
+                    // a short write (such as a full disk) is a failure
+                    isOk_ = (0 != file_) && isOk_ &&
+                        (used_ == file_->write(static_cast<const void*>(
+                            buf_.data()), 1, used_));
+                    used_ = 0;
+                }
+                if (buf_.size() > capacity_) {
+                    // grown by reserve()
+                    BufferCharArray1(capacity_).swap(buf_);
+                }
+                return isOk_; }
+
+    bool    isOk() const {
+                return isOk_; }
+
+    // The chars written since attach() (before any compression)
+    PWP_UINT64  bytesWritten() const {
+                return flushedBytes_ + used_; }
+
+private:
+
+    // The destination file
+    PwpFile *           file_;
+
+    // Compresses and writes the output if not null
+    StreamCompressor *  zip_;
+
+    // The output buffer. Only the first used_ chars are valid.
+    BufferCharArray1    buf_;
+
+    // The number of valid chars in buf_
+    size_t              used_;
+
+    // buf_ is flushed when it holds capacity_ or more chars
+    size_t              capacity_;
+
+    // The chars flushed since attach()
+    PWP_UINT64          flushedBytes_;
+
+    // false if a write to file_ failed
+    bool                isOk_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The material and zone id of each block or domain condition indexed by block
+// or domain id. Resolved once up front so lookups need no grid model calls
+// and no mutable state. Unknown ids and unset conditions are undefined.
+class CondTable {
+public:
+    explicit CondTable(MonotonicArena &arena) :
+        material_(arena),
+        zone_(arena),
+        undefinedCnt_(0)
+    {
+    }
+
+    ~CondTable()
+    {
+    }
+
+    void    resize(const PWP_UINT32 cnt) {
+                material_.assign(size_t(cnt), MatUndefined);
+                zone_.assign(size_t(cnt), ZoneUndefined);
+                undefinedCnt_ = 0; }
+
+    // Releases all memory
+    void    clear() {
+                releaseArray(material_);
+                releaseArray(zone_);
+                undefinedCnt_ = 0; }
+
+    PWP_UINT32 size() const {
+                return PWP_UINT32(material_.size()); }
+
+    void    set(const PWP_UINT32 id, const MaterialId matId,
+                const ZoneId zoneId) {
+                material_[id] = matId;
+                zone_[id] = zoneId; }
+
+    void    get(const PWP_UINT32 id, MaterialId &matId,
+                ZoneId &zoneId) const {
+                if (id < material_.size()) {
+                    matId = material_[id];
+                    zoneId = zone_[id];
+                }
+                else {
+                    matId = MatUndefined;
+                    zoneId = ZoneUndefined;
+                }
+                if (MatUndefined == matId) {
+                    undefinedCnt_.fetch_add(1, std::memory_order_relaxed);
+                } }
+
+    // The get() calls that returned an undefined condition since the last
+    // resize(). Every lookup is a table read, so this is not a cache miss
+    // count.
+    size_t  undefinedCount() const {
+                return undefinedCnt_.load(std::memory_order_relaxed); }
+
+private:
+
+    // The material id of each condition
+    Int32Array1     material_;
+
+    // The zone id of each condition
+    Int32Array1     zone_;
+
+    // Counted by get(), which may be called concurrently
+    mutable std::atomic<size_t> undefinedCnt_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The tri and quad connectivity of every element indexed by element index.
+// Loaded once from the grid model with one pass of CaeUnsElement and reused by
+// every pass that needs element vertices. The 4th vertex of a tri is
+// PWP_UINT32_UNDEF.
+class ElemTable {
+public:
+    explicit ElemTable(MonotonicArena &arena) :
+        verts_(arena)
+    {
+    }
+
+    ~ElemTable()
+    {
+    }
+
+    void    resize(const PWP_UINT32 cnt) {
+                verts_.resize(size_t(cnt) * 4); }
+
+    // Releases all memory
+    void    clear() {
+                releaseArray(verts_); }
+
+    PWP_UINT32 size() const {
+                return PWP_UINT32(verts_.size() / 4); }
+
+    // Stores the vertices of d at ndx. Returns false if d is not a tri or
+    // quad.
+    bool    set(const PWP_UINT32 ndx, const PWGM_ELEMDATA &d) {
+                PWP_UINT32 *v = verts_.data() + size_t(ndx) * 4;
+                if (PWGM_ELEMTYPE_TRI == d.type) {
+                    v[3] = PWP_UINT32_UNDEF;
+                }
+                else if (PWGM_ELEMTYPE_QUAD == d.type) {
+                    v[3] = d.index[3];
+                }
+                else {
+                    return false;
+                }
+                v[0] = d.index[0];
+                v[1] = d.index[1];
+                v[2] = d.index[2];
+                return true; }
+
+    // Returns the 4 vertices of element ndx
+    const PWP_UINT32 * verts(const PWP_UINT32 ndx) const {
+                return verts_.data() + size_t(ndx) * 4; }
+
+    bool    isQuad(const PWP_UINT32 ndx) const {
+                return PWP_UINT32_UNDEF != verts(ndx)[3]; }
+
+private:
+
+    // 4 vertex indices per element
+    UInt32Array1    verts_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The coordinates of every vertex indexed by vertex index, stored interleaved
+// as {x, y, z}. Loaded once from the grid model and shared by every writer
+// and the debug log.
+class CoordTable {
+public:
+    explicit CoordTable(MonotonicArena &arena) :
+        xyz_(arena)
+    {
+    }
+
+    ~CoordTable()
+    {
+    }
+
+    void    resize(const PWP_UINT32 cnt) {
+                xyz_.resize(size_t(cnt) * 3); }
+
+    // Releases all memory
+    void    clear() {
+                releaseArray(xyz_); }
+
+    PWP_UINT32 size() const {
+                return PWP_UINT32(xyz_.size() / 3); }
+
+    void    set(const PWP_UINT32 ndx, const PWP_REAL x, const PWP_REAL y,
+                const PWP_REAL z) {
+                PWP_REAL *p = xyz_.data() + size_t(ndx) * 3;
+                p[0] = x;
+                p[1] = y;
+                p[2] = z; }
+
+    // Returns the {x, y, z} of vertex ndx
+    const PWP_REAL * xyz(const PWP_UINT32 ndx) const {
+                return xyz_.data() + size_t(ndx) * 3; }
+
+private:
+
+    // 3 coordinates per vertex
+    RealArray1      xyz_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Measures elapsed wall clock time
+class Stopwatch {
+public:
+    Stopwatch() :
+        start_(Clock::now())
+    {
+    }
+
+    ~Stopwatch()
+    {
+    }
+
+    void    restart() {
+                start_ = Clock::now(); }
+
+    // Returns the seconds since construction or the last restart()
+    double  seconds() const {
+                return std::chrono::duration<double>(Clock::now() -
+                    start_).count(); }
+
+private:
+    typedef std::chrono::steady_clock   Clock;
+
+    // The start time
+    Clock::time_point   start_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The wall and CPU time of each export phase and a few counters that explain
+// them. Written as JSON by write(). The CPU time is the process CPU time of
+// all threads, so it exceeds the wall time of a phase that runs in parallel.
+class ExportStats {
+public:
+
+    enum Phase {
+        PhaseExport,        // beginExport() to endExport()
+        PhaseInit,          // init()
+        PhaseClassify,      // classifyEdges() (part of init)
+        PhaseNodeTables,    // buildNodeTables() (part of init)
+        PhaseVertices,      // loadVertices()
+        PhaseSortNbors,     // sortNbors()
+        PhaseElements,      // loadElements()
+        PhaseHeader,        // writeHeader()
+        PhaseNodes,         // writeNodes()
+        PhaseFaces,         // writeFaces()
+        PhaseGeometry,      // writeGeometry()
+        PhaseBinary,        // writeBinary()
+        PhaseSize
+    };
+
+    enum Count {
+        CountNodes,
+        CountElements,
+        CountBndryEdges,
+        CountIntorEdges,
+        CountCnxnEdges,
+        CountGeomEdges,
+        CountBlkCondUndefined, // block VC lookups that found no condition
+        CountDomCondUndefined, // domain BC lookups that found no condition
+        CountBytesWritten,  // .nlist bytes before any compression
+        CountSize
+    };
+
+    enum {
+        // NborBins - 1 or more neighbors share the last bin
+        NborBins = 17
+    };
+
+    ExportStats()
+    {
+        reset();
+    }
+
+    ~ExportStats()
+    {
+    }
+
+    void    reset() {
+                for (int ii = 0; ii < PhaseSize; ++ii) {
+                    phases_[ii] = PhaseTimes();
+                }
+                std::fill_n(counts_, int(CountSize), PWP_UINT64(0));
+                std::fill_n(nborBins_, int(NborBins), PWP_UINT64(0)); }
+
+    void    start(const Phase phase) {
+                PhaseTimes &t = phases_[phase];
+                t.wallStart = Clock::now();
+                t.cpuStart = processCpuSeconds(); }
+
+    // Adds the time since start(phase)
+    void    stop(const Phase phase) {
+                PhaseTimes &t = phases_[phase];
+                t.wall += std::chrono::duration<double>(Clock::now() -
+                    t.wallStart).count();
+                t.cpu += processCpuSeconds() - t.cpuStart;
+                ++t.runCnt; }
+
+    void    set(const Count cnt, const PWP_UINT64 val) {
+                counts_[cnt] = val; }
+
+    void    add(const Count cnt, const PWP_UINT64 val) {
+                counts_[cnt] += val; }
+
+    PWP_UINT64 count(const Count cnt) const {
+                return counts_[cnt]; }
+
+    void    setNborHistogram(const NodeNbors &nbors) {
+                std::fill_n(nborBins_, int(NborBins), PWP_UINT64(0));
+                for (PWP_UINT32 ii = 0; ii < nbors.nodeCount(); ++ii) {
+                    ++nborBins_[std::min(nbors.nborCount(ii),
+                        PWP_UINT32(NborBins - 1))];
+                } }
+
+    // Writes the JSON summary to fileName. Phases that did not run are
+    // left out.
+    bool    write(const std::string &fileName, const bool isOk) const {
+                static const char *PhaseNames[PhaseSize] = {
+                    "export", "init", "classify", "nodeTables", "vertices",
+                    "sortNbors", "elements", "header", "nodes", "faces",
+                    "geometry", "binary" };
+                static const char *CountNames[CountSize] = {
+                    "nodes", "elements", "boundaryEdges", "interiorEdges",
+                    "connectionEdges", "geometryEdges",
+                    "blockCondUndefinedLookups",
+                    "domainCondUndefinedLookups", "bytesWritten" };
+                PwpFile f;
+                if (!f.open(fileName, pwpWrite | pwpAscii)) {
+                    return false;
+                }
+                bool ret = f.writef("{\n  \"ok\": %s,\n  \"phases\": [",
+                    isOk ? "true" : "false");
+                const char *sep = "\n";
+                for (int ii = 0; ii < PhaseSize; ++ii) {
+                    const PhaseTimes &t = phases_[ii];
+                    if (0 != t.runCnt) {
+                        ret = ret && f.writef("%s    { \"name\": \"%s\", "
+                            "\"wallSec\": %.6f, \"cpuSec\": %.6f }", sep,
+                            PhaseNames[ii], t.wall, t.cpu);
+                        sep = ",\n";
+                    }
+                }
+                ret = ret && f.write("\n  ],\n  \"counts\": {");
+                sep = "\n";
+                for (int ii = 0; ii < CountSize; ++ii) {
+                    ret = ret && f.writef("%s    \"%s\": %llu", sep,
+                        CountNames[ii], (unsigned long long)counts_[ii]);
+                    sep = ",\n";
+                }
+                // nborHistogram[n] is the number of nodes with n neighbors
+                ret = ret && f.write("\n  },\n  \"nborHistogram\": [");
+                for (int ii = 0; ii < NborBins; ++ii) {
+                    ret = ret && f.writef("%s%llu", (0 == ii) ? "" : ", ",
+                        (unsigned long long)nborBins_[ii]);
+                }
+                ret = ret && f.write("]\n}\n");
+                return f.close() && ret; }
+
+private:
+
+    typedef std::chrono::steady_clock   Clock;
+
+    // The CPU seconds used by all threads of the process. std::clock() is
+    // the wall time on Windows.
+    static double processCpuSeconds() {
+#if defined(WINDOWS)
+                FILETIME create;
+                FILETIME exit;
+                FILETIME kernel;
+                FILETIME user;
+                if (!::GetProcessTimes(::GetCurrentProcess(), &create, &exit,
+                        &kernel, &user)) {
+                    return 0.0;
+                }
+                // In 100 ns ticks
+                const ULONGLONG ticks =
+                    ((ULONGLONG(kernel.dwHighDateTime) << 32) |
+                        kernel.dwLowDateTime) +
+                    ((ULONGLONG(user.dwHighDateTime) << 32) |
+                        user.dwLowDateTime);
+                return double(ticks) * 1.0e-7;
+#else
+                timespec ts;
+                if (0 != ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts)) {
+                    return 0.0;
+                }
+                return double(ts.tv_sec) + double(ts.tv_nsec) * 1.0e-9;
+#endif
+                }
+
+    struct PhaseTimes {
+        PhaseTimes() :
+            wallStart(),
+            cpuStart(0.0),
+            wall(0.0),
+            cpu(0.0),
+            runCnt(0)
+        {
+        }
+
+        Clock::time_point   wallStart;
+        double              cpuStart;
+        double              wall;
+        double              cpu;
+        PWP_UINT32          runCnt;
+    };
+
+private:
+
+    PhaseTimes  phases_[PhaseSize];
+    PWP_UINT64  counts_[CountSize];
+    PWP_UINT64  nborBins_[NborBins];
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Decides when the progress of a step is sent to the host. A step of total
+// items is reported as at most maxSteps increments. An increment is due when
+// the completed fraction reaches it. If interval seconds have passed since
+// the last increment, the next one is sent early so that abort requests are
+// still seen during slow steps. The reported progress never leads by more
+// than one increment.
+class ProgressThrottle {
+public:
+    ProgressThrottle() :
+        total_(0),
+        done_(0),
+        steps_(0),
+        sent_(0),
+        maxSteps_(100),
+        interval_(0.25),
+        timer_()
+    {
+    }
+
+    ~ProgressThrottle()
+    {
+    }
+
+    // An interval of 0 disables the early increments
+    void        setLimits(const PWP_UINT32 maxSteps, const double interval) {
+                    maxSteps_ = std::max(PWP_UINT32(1), maxSteps);
+                    interval_ = interval; }
+
+    // Starts a step of total items. Returns the number of increments.
+    PWP_UINT32  begin(const PWP_UINT32 total) {
+                    total_ = total;
+                    done_ = 0;
+                    steps_ = std::min(total, maxSteps_);
+                    sent_ = 0;
+                    timer_.restart();
+                    return steps_; }
+
+    // Adds cnt completed items. Returns the number of increments to send.
+    PWP_UINT32  advance(const PWP_UINT32 cnt) {
+                    if (sent_ >= steps_) {
+                        return 0;
+                    }
+                    done_ = std::min(PWP_UINT64(total_), done_ + cnt);
+                    const PWP_UINT32 reached = PWP_UINT32(done_ * steps_ /
+                        total_);
+                    PWP_UINT32 due = std::max(reached, sent_);
+                    if (due == sent_ && reached == sent_ && interval_ > 0.0 &&
+                            timer_.seconds() >= interval_) {
+                        due = sent_ + 1;
+                    }
+                    const PWP_UINT32 ret = due - sent_;
+                    if (0 != ret) {
+                        sent_ = due;
+                        timer_.restart();
+                    }
+                    return ret; }
+
+private:
+
+    // Items in the step
+    PWP_UINT32  total_;
+
+    // Items completed so far
+    PWP_UINT64  done_;
+
+    // Increments in the step
+    PWP_UINT32  steps_;
+
+    // Increments sent so far
+    PWP_UINT32  sent_;
+
+    // Max increments per step
+    PWP_UINT32  maxSteps_;
+
+    // Max seconds between increments (0 to disable)
+    double      interval_;
+
+    // Time since the last increment
+    Stopwatch   timer_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Selects the nodes written to the debug log by the log level and then by the
+// optional material id, zone id and node id lists. A list such as "1,4-6"
+// holds ids and inclusive id ranges. An empty list selects every id. Node ids
+// are 1-based as in the log node lines.
+class LogFilter {
+public:
+    enum Level {
+        LevelSummary,   // no nodes or edges, only the summary comments
+        LevelConflicts, // nodes with a material or zone conflict
+        LevelBoundary,  // boundary nodes
+        LevelFull       // every node
+    };
+
+    LogFilter() :
+        level_(LevelFull),
+        mats_(),
+        zones_(),
+        nodes_()
+    {
+    }
+
+    ~LogFilter()
+    {
+    }
+
+    void        setLevel(const Level level) {
+                    level_ = level; }
+
+    // Each set*() returns false and selects every id if list is invalid
+    bool        setMaterials(const char *list) {
+                    return parseList(list, mats_); }
+
+    bool        setZones(const char *list) {
+                    return parseList(list, zones_); }
+
+    bool        setNodes(const char *list) {
+                    return parseList(list, nodes_); }
+
+    // false if no node can be logged
+    bool        logsNodes() const {
+                    return LevelSummary != level_; }
+
+    // true if every node is logged
+    bool        logsAll() const {
+                    return LevelFull == level_ && mats_.empty() &&
+                        zones_.empty() && nodes_.empty(); }
+
+    // Returns true if the node at 0-based index ndx is logged
+    bool        matches(const PWP_UINT32 ndx, const MaterialId matId,
+                    const ZoneId zoneId, const bool isBndry,
+                    const bool hadConflict) const {
+                    bool ret = false;
+                    switch (level_) {
+                    case LevelSummary:      ret = false; break;
+                    case LevelConflicts:    ret = hadConflict; break;
+                    case LevelBoundary:     ret = isBndry; break;
+                    case LevelFull:         ret = true; break;
+                    }
+                    return ret && isListed(nodes_, PWP_INT64(ndx) + 1) &&
+                        isListed(mats_, matId) && isListed(zones_, zoneId); }
+
+private:
+
+    typedef std::pair<PWP_INT64, PWP_INT64> IdRange;
+    typedef std::vector<IdRange>            IdRangeArray1;
+
+    static bool isListed(const IdRangeArray1 &ranges, const PWP_INT64 id) {
+                    if (ranges.empty()) {
+                        return true;
+                    }
+                    IdRangeArray1::const_iterator it = ranges.begin();
+                    for (; ranges.end() != it; ++it) {
+                        if (id >= it->first && id <= it->second) {
+                            return true;
+                        }
+                    }
+                    return false; }
+
+    static bool parseList(const char *list, IdRangeArray1 &ranges) {
+                    ranges.clear();
+                    const char *p = list;
+                    while (0 != p && '\0' != *p) {
+                        char *end = 0;
+                        IdRange range;
+                        range.first = strtoll(p, &end, 10);
+                        if (end == p) {
+                            break;
+                        }
+                        range.second = range.first;
+                        p = skipSpaces(end);
+                        if ('-' == *p) {
+                            range.second = strtoll(p + 1, &end, 10);
+                            if (end == p + 1 || range.second < range.first) {
+                                break;
+                            }
+                            p = skipSpaces(end);
+                        }
+                        ranges.push_back(range);
+                        if (',' == *p) {
+                            ++p;
+                        }
+                        else if ('\0' != *p) {
+                            break;
+                        }
+                    }
+                    const bool ret = (0 == p) || ('\0' == *skipSpaces(p));
+                    if (!ret) {
+                        ranges.clear();
+                    }
+                    return ret; }
+
+    static const char* skipSpaces(const char *p) {
+                    while (' ' == *p || '\t' == *p) {
+                        ++p;
+                    }
+                    return p; }
+
+private:
 
-typedef std::map<PWP_UINT32, NodeInfo>  NInfoMap;
-typedef NInfoMap::value_type            NInfoMapVal;
-typedef NInfoMap::iterator              NInfoIter;
-typedef NInfoMap::const_iterator        NInfoCIter;
+    // The nodes selected before the lists are applied
+    Level           level_;
+
+    // The selected material ids (empty for all)
+    IdRangeArray1   mats_;
+
+    // The selected zone ids (empty for all)
+    IdRangeArray1   zones_;
+
+    // The selected 1-based node ids (empty for all)
+    IdRangeArray1   nodes_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// A file created with a fixed size and mapped into memory for writing. The
+// blocks of the file are allocated by open(), so a full disk fails open()
+// instead of raising SIGBUS while the mapping is filled. Not supported on
+// WINDOWS builds (open() always fails).
+class MappedFile {
+public:
+    MappedFile() :
+        data_(0),
+        size_(0),
+        fd_(-1)
+    {
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    // Creates or truncates fileName, allocates size zero bytes for it and
+    // maps it. Returns false if the space cannot be allocated or the file
+    // cannot be mapped.
+    bool    open(const char *fileName, const size_t size) {
+                close();
+#if !defined(WINDOWS)
+                fd_ = ::open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0666);
+                if (fd_ < 0) {
+                    return false;
+                }
+                void *p = MAP_FAILED;
+                if (0 == ::posix_fallocate(fd_, 0, off_t(size))) {
+                    p = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd_, 0);
+                }
+                if (MAP_FAILED == p) {
+                    ::close(fd_);
+                    fd_ = -1;
+                    return false;
+                }
+                data_ = static_cast<char*>(p);
+                size_ = size;
+                return true;
+#else
+                (void)fileName;
+                (void)size;
+                return false;
+#endif
+                }
+
+    // Writes the mapped data to the file, unmaps it and closes the file.
+    // Returns false if the data could not be written.
+    bool    close() {
+                bool ret = true;
+#if !defined(WINDOWS)
+                if (0 != data_) {
+                    // munmap() and close() do not report write errors
+                    ret = (0 == ::msync(data_, size_, MS_SYNC));
+                    ret = (0 == ::munmap(data_, size_)) && ret;
+                }
+                if (fd_ >= 0) {
+                    ret = (0 == ::close(fd_)) && ret;
+                }
+#endif
+                data_ = 0;
+                size_ = 0;
+                fd_ = -1;
+                return ret; }
+
+    bool    isOpen() const {
+                return 0 != data_; }
+
+    char*   data() const {
+                return data_; }
+
+private:
+
+    // The mapped file contents
+    char *      data_;
+
+    // The mapped size in bytes
+    size_t      size_;
+
+    // The file descriptor
+    int         fd_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The raw face stream data of one edge and, once classified, the material and
+// zone id pushed to its nodes. Captured by streamFace() and classified in
+// parallel by classifyEdges(), or classified right away by a serial stream.
+struct EdgeRec {
+    // flags bits
+    enum {
+        IsValid     = 0x01, // the edge was classified
+        MzFromVC    = 0x02, // matId and zoneId came from a VC
+        IsGeomEdge  = 0x04  // the edge is added to geomEdges_
+    };
+
+    PWGM_ENUM_FACETYPE  type;
+    PWP_UINT32          ownerBlk;   // owner block id
+    PWP_UINT32          ownerDom;   // owner domain id or PWP_UINT32_UNDEF
+    PWP_UINT32          nborCell;   // model index of the neighbor element
+    MaterialId          matId;
+    ZoneId              zoneId;
+    PWP_UINT8           flags;
+};
+
+// Uses the heap like the other face stream arrays (see StreamEdgeArray1)
+typedef std::vector<EdgeRec>    EdgeRecArray1;
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The formatted NODES section text (and log text) of a range of nodes. The
+// buffers are reused from one range to the next. Only the first textLen and
+// logLen chars are valid.
+struct NodeChunk {
+    NodeChunk() :
+        text(),
+        textLen(0),
+        log(),
+        logLen(0),
+        logCnt(0),
+        isValid(true)
+    {
+    }
+
+    BufferCharArray1    text;
+    size_t              textLen;
+    BufferCharArray1    log;
+    size_t              logLen;
+    PWP_UINT32          logCnt;  // the nodes in log
+    bool                isValid; // false if a node had no neighbors
+};
+
+// Uses the heap. Local to writeNodes() and logNodes().
+typedef std::vector<NodeChunk>  NodeChunkArray1;
 
 
 //----------------------------------------------------------------------------
@@ -202,6 +2132,14 @@ typedef NInfoMap::const_iterator        NInfoCIter;
 
 class CaeUnsUMCPSEG : public CaeUnsPlugin, public CaeFaceStreamHandler {
 public:
+    // The order of the neighbors of each node (set by the "NeighborOrder"
+    // solver attribute)
+    enum NborOrder {
+        NborOrderStream,    // face stream order
+        NborOrderIndex,     // increasing vertex index
+        NborOrderAngle      // counter-clockwise from +x around the node
+    };
+
     CaeUnsUMCPSEG(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
         const CAEP_WRITEINFO *pWriteInfo);
 
@@ -211,11 +2149,28 @@ public:
 
     static void destroy(CAEP_RTITEM &rti);
 
-private:
+protected:
     virtual bool        beginExport();
     virtual PWP_BOOL    write();
     virtual bool        endExport();
 
+    // The export phases run by write(), in order. A derived driver can run
+    // and time one phase at a time (tools/harness/umcpseg_bench.cxx).
+    bool        init();
+    bool        streamEdges();
+    void        buildNodeTables();
+    bool        loadVertices();
+    bool        sortNbors();
+    bool        loadElements();
+    bool        writeNodes();
+    bool        writeFaces();
+    bool        writeGeometry();
+    bool        flushOutput();
+
+    const MonotonicArena & arena() const {
+                    return arena_; }
+
+private:
     // face streaming handlers
     virtual PWP_UINT32 streamBegin(const PWGM_BEGINSTREAM_DATA &data);
     virtual PWP_UINT32 streamFace(const PWGM_FACESTREAM_DATA &data);
@@ -224,75 +2179,199 @@ private:
 private:
     // Plugin implementation helper methods
 
-    bool        init();
+    bool        runPhase(const ExportStats::Phase phase,
+                    bool (CaeUnsUMCPSEG::*func)());
+    bool        beginThrottledStep(const PWP_UINT32 total);
+    bool        throttledIncrement(const PWP_UINT32 cnt = 1);
+    void        buildElemBlocks();
+    bool        lookupElemBlocks();
+    bool        checkNborBlk(const PWP_UINT32 cell);
+    bool        buildCondTables();
     bool        writeHeader();
-    bool        writeNodes();
-    bool        writeOneNode(const CaeUnsVertex &v, const NodeInfo &info);
-    bool        writeFaces();
-    bool        writeOneFace(const PWP_UINT32 n0, const PWP_UINT32 n1,
-                    const PWP_UINT32 n2);
-    bool        writeGeometry();
+    void        makeHeaderText(std::string &text) const;
+    void        formatNodes(NodeChunk &chunk, const PWP_UINT32 first,
+                    const PWP_UINT32 last, const bool doText,
+                    const bool doLog) const;
+    void        nodeChunkMaxChars(const PWP_UINT32 first,
+                    const PWP_UINT32 last, const bool doText,
+                    const bool doLog, size_t &textMax,
+                    size_t &logMax) const;
+    PWP_UINT32  nodeBatchEnd(const PWP_UINT32 c0, const bool doText,
+                    const bool doLog, const size_t maxChars) const;
+    void        logEdge(const Edge &e);
+    bool        isNodeLogged(const PWP_UINT32 ndx) const;
+    void        logText(const char *text);
+    void        logWritef(const char *fmt, ...);
+    bool        logNodes();
+    bool        writeBinary();
+    char*       binReserve(const PWP_UINT64 offset, const size_t cnt);
+    void        binCommit(const char *end);
+    bool        writeBinPad(const NlistBinary::Section &sec);
+    template<typename OffsetFunc, typename EncodeFunc>
+    bool        writeBinSection(const NlistBinary::Section &sec,
+                    const PWP_UINT32 chunkCnt, const OffsetFunc &offset,
+                    const EncodeFunc &encode);
+    bool        writeBinNodes(const NlistBinary::Section &xySec,
+                    const NlistBinary::Section &attrSec,
+                    const NlistBinary::Section &offsetSec,
+                    const NlistBinary::Section &nborSec);
+    bool        writeBinFaces(const NlistBinary::Section &sec);
+    bool        writeBinGeometry(const NlistBinary::Section &sec);
+
+    bool        classifyEdges();
+    bool        classifyStreamedEdge(const Edge &e, EdgeRec &rec);
+    void        countEdgeType(const PWGM_ENUM_FACETYPE type);
+    void        logEdgeSizing(const size_t edgeCnt);
+    void        logSizing(const char *what, const size_t expected,
+                    const size_t actual);
+    void        classifyEdge(EdgeRec &rec) const;
+    void        pushPts(const PWP_UINT32 first, const PWP_UINT32 last,
+                    const UInt32Span &edgeNdxs);
+    void        pushPt(const PWP_UINT32 vPt, const EdgeRec &rec);
 
-    bool        getPoint(const PWP_UINT32 vPt, NInfoIter &it,
-                    const bool allowCreate = false);
+    static bool createBCsAndVCs(CAEP_RTITEM &rti);
 
-    NInfoIter   addPoint(const PWP_UINT32 vPt);
+    bool    getEdgeMatAndZone(const EdgeRec &rec, MaterialId &matId,
+                ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const;
 
-    bool        pushPt(const PWP_UINT32 vPt, const PWP_UINT32 vNbor,
-                    const MaterialId matId, const ZoneId zoneId,
-                    const bool mzFromVC, const bool isBndry);
+    bool    getBndryEdgeMatAndZone(const EdgeRec &rec, MaterialId &matId,
+                ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const;
 
-    static bool createBCsAndVCs(CAEP_RTITEM &rti);
+    bool    getIntorEdgeMatAndZone(const EdgeRec &rec, MaterialId &matId,
+                ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const;
 
-    bool    getEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
-                MaterialId &matId, ZoneId &zoneId, bool &mzFromVC,
-                bool &isGeomEdge) const;
+    bool    getCnxnEdgeMatAndZone(const EdgeRec &rec, MaterialId &matId,
+                ZoneId &zoneId, bool &mzFromVC, bool &isGeomEdge) const;
 
-    bool    getBndryEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
-                MaterialId &matId, ZoneId &zoneId, bool &mzFromVC,
-                bool &isGeomEdge) const;
+    bool    getNborBlk(const EdgeRec &rec, PWP_UINT32 &blkId) const;
 
-    bool    getIntorEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
-                MaterialId &matId, ZoneId &zoneId, bool &mzFromVC,
-                bool &isGeomEdge) const;
+    static void getMatAndZone(const PWGM_CONDDATA &cd, MaterialId &matId,
+                    ZoneId &zoneId);
 
-    bool    getCnxnEdgeMatAndZone(const PWGM_FACESTREAM_DATA &data,
-                MaterialId &matId, ZoneId &zoneId, bool &mzFromVC,
-                bool &isGeomEdge) const;
 
-    bool    getNborBlk(const PWGM_FACESTREAM_DATA &d, CaeUnsBlock &hBlk) const;
+private:
+    // All per-export arrays allocate from arena_. Released by endExport().
+    // Declared first so it outlives the containers.
+    MonotonicArena          arena_;
 
-    void    getMatAndZone(const PWGM_HBLOCK &h, MaterialId &matId,
-                ZoneId &zoneId) const;
+    // The material, zone and boundary state of each vertex indexed by vertex
+    // index. Sized to model_.vertexCount() in streamBegin().
+    NodeTable               nodeInfo_;
 
-    void    getMatAndZone(const PWGM_HDOMAIN &h, MaterialId &matId,
-                ZoneId &zoneId) const;
+    // The neighbors of each vertex indexed by vertex index. Built from edges_
+    // by buildNodeTables().
+    NodeNbors               nodeNbors_;
 
-    static void getMatAndZone(const PWGM_CONDDATA &cd, MaterialId &matId,
-                    ZoneId &zoneId);
+    // The block index of each element indexed by model element index
+    // (transient heap memory, built by init() and released once the faces
+    // are streamed)
+    StreamUInt32Array1      elemBlk_;
 
+    // Non-zero for each element whose elemBlk_ entry was checked against its
+    // owner face data or the grid model (released with elemBlk_)
+    StreamUInt8Array1       elemBlkChecked_;
 
-private:
-    // Maps a vertex index to its accociated NodeInfo object
-    NInfoMap                nodeInfo_;
+    // False if the model element indices are not the block elements
+    // concatenated in block order. elemBlk_ is then rebuilt with
+    // lookupElemBlocks() before the edges are classified.
+    bool                    elemBlkOk_;
+
+    // Every streamed edge in stream order (transient heap memory, released
+    // by init() once nodeNbors_ is built)
+    StreamEdgeArray1        edges_;
 
-    // Array of Edge objects
+    // The face stream data of each edge in edges_ (transient heap memory,
+    // released with edges_). Empty for a serial stream.
+    EdgeRecArray1           edgeRecs_;
+
+    // True if the edges are classified and pushed to their nodes as they
+    // are streamed. Set by streamBegin() when there is only one thread.
+    bool                    serialStream_;
+
+    // The geometry edges of a serial stream in stream order (transient heap
+    // memory, copied to geomEdges_ by streamEnd())
+    StreamEdgeArray1        streamGeomEdges_;
+
+    // The coordinates of each vertex. Loaded by loadVertices().
+    CoordTable              coords_;
+
+    // The vertices of each element. Loaded by loadElements().
+    ElemTable               elems_;
+
+    // Array of Edge objects. Reserved with the exact count in
+    // classifyEdges() or streamEnd().
     EdgeArray1              geomEdges_;
 
+    // The face counts given to streamBegin(). Used to size the per-edge
+    // containers.
+    PWGM_BEGINSTREAM_DATA   streamCnts_;
+
+    // Compresses the out_ blocks (set by the "Compression" solver
+    // attribute). Only started while write() runs.
+    StreamCompressor        zip_;
+
+    // Buffered rtFile_ output (buffer size set by the "OutputBufferSize"
+    // solver attribute). All .nlist output goes through out_.
+    BufferedFile            out_;
+
+    // Number of threads used to format the output (set by the "ThreadCount"
+    // solver attribute)
+    PWP_UINT32              numThreads_;
+
+    // The numThreads_ - 1 worker threads of the parallel loops. Only started
+    // while an export runs.
+    WorkerPool              pool_;
+
+    // The order of each node's neighbors in the output
+    NborOrder               nborOrder_;
+
+    // Coalesces the progress increments of each step (set by the
+    // "ProgressSteps" and "ProgressInterval" solver attributes)
+    ProgressThrottle        progress_;
+
+    // Write binary exports through map_ (set by the "MapOutputFile" solver
+    // attribute)
+    bool                    useMap_;
+
+    // The mapped binary output file (open only while writeBinary() runs)
+    MappedFile              map_;
+
+    // The binary FACES count before each chunk of elements (transient)
+    SizeArray1              faceChunkOffsets_;
+
     // Debug log file (dis/enabled by "CreateLog" solver attribute)
     PwpFile                 log_;
 
-    // Id of current block being processed (transient runtime value)
-    mutable PWP_UINT32      curBlkId_;
+    // Buffered log_ output. All log output goes through logOut_.
+    BufferedFile            logOut_;
+
+    // Write log_ as binary NlistLog records (set by the "LogFormat" solver
+    // attribute)
+    bool                    binaryLog_;
+
+    // The nodes and edges written to log_ (set by the "LogLevel",
+    // "LogMaterials", "LogZones" and "LogNodes" solver attributes)
+    LogFilter               logFilter_;
+
+    // The nodes and edges written to log_
+    PWP_UINT32              logNodeCnt_;
+    PWP_UINT32              logEdgeCnt_;
+
+    // Phase times and counters of the export. Written to the .stats.json
+    // file if createStats_ is set.
+    ExportStats             stats_;
+
+    // Set by the "CreateStats" solver attribute
+    bool                    createStats_;
 
-    // VC of current block being processed (transient runtime value)
-    mutable PWGM_CONDDATA   curBlkCond_;
+    // The result of write() for the stats file
+    bool                    writeOk_;
 
-    // Id of current domain being processed (transient runtime value)
-    mutable PWP_UINT32      curDomId_;
+    // The VC material and zone id of each block. Built by init().
+    CondTable               blkConds_;
 
-    // BC of current domain being processed (transient runtime value)
-    mutable PWGM_CONDDATA   curDomCond_;
+    // The BC material and zone id of each domain. Built by init().
+    CondTable               domConds_;
 
     // Collection of BC and VC type names generated by createBCsAndVCs().
     static StdStringCache   typeNames_;
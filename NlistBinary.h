@@ -0,0 +1,472 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * class NlistBinary
+ * class NlistBinaryReader
+ *
+ * The binary .nlist format. It holds the same data as the ASCII .nlist
+ * NODES, FACES and GEOMETRY sections as fixed-width little-endian arrays.
+ *
+ * File layout:
+ *
+ *   File header (16 bytes)
+ *     char[8]  magic "NLISTBIN"
+ *     uint32   version (NlistBinary::Version)
+ *     uint32   number of sections
+ *
+ *   Section table (32 bytes per section)
+ *     uint32   section id (NlistBinary::SectionId)
+ *     uint32   section parameter (NODES subtype for NodeXY, otherwise 0)
+ *     uint64   item count
+ *     uint64   file offset of the section data (8 byte aligned)
+ *     uint64   byte size of the section data
+ *
+ *   Section data (zero padded to the next 8 byte boundary)
+ *     Header           char[count]         the 2 line ASCII file header
+ *     NodeXY           float64[count][2]   x, y
+ *     NodeAttr         int32[count][3]     matId, zoneId, NodeFlags
+ *     NodeNborOffsets  uint32[count]       nodeCnt + 1 CSR offsets
+ *     NodeNbors        uint32[count]       0-based neighbor indices
+ *     Faces            uint32[count][3]    0-based tri vertices (quads are
+ *                                          split as in the ASCII file)
+ *     Geometry         float64[count][4]   x0, y0, x1, y1
+ *
+ * Unknown section ids must be skipped by readers. This file does not depend
+ * on the PluginSDK.
+ *
+ ***************************************************************************/
+
+#ifndef _NLISTBINARY_H_
+#define _NLISTBINARY_H_
+
+#include<cstdio>
+#include<cstring>
+#include<stdint.h>
+#include<string>
+#include<vector>
+
+
+class NlistBinary {
+public:
+
+    enum {
+        // The current format version
+        Version = 1,
+        // Bytes in the file header
+        FileHeaderBytes = 16,
+        // Bytes in one section table entry
+        SectionBytes = 32,
+        // Section data alignment
+        Alignment = 8
+    };
+
+    enum SectionId {
+        Header = 1,
+        NodeXY = 2,
+        NodeAttr = 3,
+        NodeNborOffsets = 4,
+        NodeNbors = 5,
+        Faces = 6,
+        Geometry = 7
+    };
+
+    // NodeAttr flags bits
+    enum NodeFlags {
+        NodeBndry = 0x01,
+        NodeMatConflict = 0x02,
+        NodeZoneConflict = 0x04
+    };
+
+    // One section table entry
+    struct Section {
+        uint32_t    id;
+        uint32_t    param;
+        uint64_t    count;
+        uint64_t    offset;
+        uint64_t    bytes;
+    };
+
+    typedef std::vector<Section>    SectionArray1;
+
+
+    static const char* magic()
+    {
+        return "NLISTBIN";
+    }
+
+    // Returns the bytes per item of section id or 0 if id is unknown
+    static uint64_t itemBytes(const uint32_t id)
+    {
+        switch (id) {
+        case Header:            return 1;
+        case NodeXY:            return 16;
+        case NodeAttr:          return 12;
+        case NodeNborOffsets:   return 4;
+        case NodeNbors:         return 4;
+        case Faces:             return 12;
+        case Geometry:          return 32;
+        }
+        return 0;
+    }
+
+    // Sets the bytes and offset of each section from its id and count. The
+    // sections are placed in array order after the section table.
+    static void layout(SectionArray1 &secs)
+    {
+        uint64_t offset = align(FileHeaderBytes +
+            uint64_t(secs.size()) * SectionBytes);
+        for (size_t ii = 0; ii < secs.size(); ++ii) {
+            secs[ii].bytes = secs[ii].count * itemBytes(secs[ii].id);
+            secs[ii].offset = offset;
+            offset = align(offset + secs[ii].bytes);
+        }
+    }
+
+    // Returns the byte size of the file header, section table and padding
+    // up to the first section
+    static uint64_t tableBytes(const SectionArray1 &secs)
+    {
+        return align(FileHeaderBytes + uint64_t(secs.size()) * SectionBytes);
+    }
+
+    // Writes the file header and section table to p (tableBytes(secs)
+    // chars). Returns the end of the written chars.
+    static char* putTable(char *p, const SectionArray1 &secs)
+    {
+        char * const beg = p;
+        memcpy(p, magic(), 8);
+        p = putU32(p + 8, Version);
+        p = putU32(p, uint32_t(secs.size()));
+        for (size_t ii = 0; ii < secs.size(); ++ii) {
+            p = putU32(p, secs[ii].id);
+            p = putU32(p, secs[ii].param);
+            p = putU64(p, secs[ii].count);
+            p = putU64(p, secs[ii].offset);
+            p = putU64(p, secs[ii].bytes);
+        }
+        return putPad(p, size_t(tableBytes(secs) - uint64_t(p - beg)));
+    }
+
+    static uint64_t align(const uint64_t offset)
+    {
+        return (offset + Alignment - 1) / Alignment * Alignment;
+    }
+
+    static char* putPad(char *p, const size_t cnt)
+    {
+        memset(p, 0, cnt);
+        return p + cnt;
+    }
+
+    static char* putU32(char *p, const uint32_t val)
+    {
+        p[0] = char(val & 0xFF);
+        p[1] = char((val >> 8) & 0xFF);
+        p[2] = char((val >> 16) & 0xFF);
+        p[3] = char((val >> 24) & 0xFF);
+        return p + 4;
+    }
+
+    static char* putI32(char *p, const int32_t val)
+    {
+        return putU32(p, uint32_t(val));
+    }
+
+    static char* putU64(char *p, const uint64_t val)
+    {
+        p = putU32(p, uint32_t(val & 0xFFFFFFFFu));
+        return putU32(p, uint32_t(val >> 32));
+    }
+
+    static char* putF64(char *p, const double val)
+    {
+        uint64_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        return putU64(p, bits);
+    }
+
+    static uint32_t getU32(const char *p)
+    {
+        const unsigned char *u = reinterpret_cast<const unsigned char*>(p);
+        return uint32_t(u[0]) | (uint32_t(u[1]) << 8) |
+            (uint32_t(u[2]) << 16) | (uint32_t(u[3]) << 24);
+    }
+
+    static int32_t getI32(const char *p)
+    {
+        return int32_t(getU32(p));
+    }
+
+    static uint64_t getU64(const char *p)
+    {
+        return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+    }
+
+    static double getF64(const char *p)
+    {
+        const uint64_t bits = getU64(p);
+        double ret;
+        memcpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Reads a binary .nlist file into memory and provides random access to its
+// data. All indices are 0-based.
+class NlistBinaryReader {
+public:
+    NlistBinaryReader() :
+        data_(),
+        secs_(),
+        header_(0),
+        nodeXY_(0),
+        nodeAttr_(0),
+        nborOffsets_(0),
+        nbors_(0),
+        faces_(0),
+        geometry_(0),
+        error_()
+    {
+    }
+
+    ~NlistBinaryReader()
+    {
+    }
+
+    // Reads and validates the file. Returns false and sets error() if the
+    // file cannot be read or is not a valid binary .nlist file. A valid file
+    // has every neighbor and face vertex index below nodeCount().
+    bool read(const char *fileName)
+    {
+        data_.clear();
+        FILE *fp = fopen(fileName, "rb");
+        if (0 == fp) {
+            return fail("cannot open file");
+        }
+        char buf[65536];
+        size_t cnt;
+        while (0 != (cnt = fread(buf, 1, sizeof(buf), fp))) {
+            data_.insert(data_.end(), buf, buf + cnt);
+        }
+        const bool hadError = (0 != ferror(fp));
+        fclose(fp);
+        return hadError ? fail("read error") : parse();
+    }
+
+    // Validates data already in memory
+    bool read(const char *data, const size_t bytes)
+    {
+        data_.assign(data, data + bytes);
+        return parse();
+    }
+
+    const char* error() const {
+        return error_.c_str(); }
+
+    // The NODES subtype (5 for Pointwise generated files)
+    uint32_t nodeSubType() const {
+        return nodeXY_->param; }
+
+    // The ASCII file header lines
+    const char* headerText() const {
+        return data(*header_); }
+
+    size_t headerBytes() const {
+        return size_t(header_->bytes); }
+
+    uint32_t nodeCount() const {
+        return uint32_t(nodeXY_->count); }
+
+    double x(const uint32_t ndx) const {
+        return NlistBinary::getF64(data(*nodeXY_) + size_t(ndx) * 16); }
+
+    double y(const uint32_t ndx) const {
+        return NlistBinary::getF64(data(*nodeXY_) + size_t(ndx) * 16 + 8); }
+
+    int32_t matId(const uint32_t ndx) const {
+        return NlistBinary::getI32(data(*nodeAttr_) + size_t(ndx) * 12); }
+
+    int32_t zoneId(const uint32_t ndx) const {
+        return NlistBinary::getI32(data(*nodeAttr_) + size_t(ndx) * 12 + 4); }
+
+    uint32_t nodeFlags(const uint32_t ndx) const {
+        return NlistBinary::getU32(data(*nodeAttr_) + size_t(ndx) * 12 + 8); }
+
+    bool isBndry(const uint32_t ndx) const {
+        return 0 != (nodeFlags(ndx) & NlistBinary::NodeBndry); }
+
+    uint32_t nborCount(const uint32_t ndx) const {
+        return nborOffset(ndx + 1) - nborOffset(ndx); }
+
+    uint32_t nbor(const uint32_t ndx, const uint32_t ii) const {
+        return NlistBinary::getU32(data(*nbors_) +
+            (size_t(nborOffset(ndx)) + ii) * 4); }
+
+    uint32_t faceCount() const {
+        return uint32_t(faces_->count); }
+
+    // Returns vertex ii (0..2) of face ndx
+    uint32_t faceVert(const uint32_t ndx, const uint32_t ii) const {
+        return NlistBinary::getU32(data(*faces_) + size_t(ndx) * 12 +
+            ii * 4); }
+
+    uint32_t geometryCount() const {
+        return uint32_t(geometry_->count); }
+
+    // Returns value ii (x0, y0, x1, y1) of geometry edge ndx
+    double geometry(const uint32_t ndx, const uint32_t ii) const {
+        return NlistBinary::getF64(data(*geometry_) + size_t(ndx) * 32 +
+            ii * 8); }
+
+private:
+
+    typedef NlistBinary::Section        Section;
+    typedef NlistBinary::SectionArray1  SectionArray1;
+
+    bool parse()
+    {
+        header_ = nodeXY_ = nodeAttr_ = nborOffsets_ = nbors_ = faces_ =
+            geometry_ = 0;
+        secs_.clear();
+        if (data_.size() < size_t(NlistBinary::FileHeaderBytes) ||
+                0 != memcmp(data_.data(), NlistBinary::magic(), 8)) {
+            return fail("not a binary .nlist file");
+        }
+        if (NlistBinary::Version != NlistBinary::getU32(data_.data() + 8)) {
+            return fail("unsupported version");
+        }
+        const uint64_t secCnt = NlistBinary::getU32(data_.data() + 12);
+        if (data_.size() < NlistBinary::FileHeaderBytes +
+                secCnt * NlistBinary::SectionBytes) {
+            return fail("truncated section table");
+        }
+        const char *p = data_.data() + NlistBinary::FileHeaderBytes;
+        for (uint64_t ii = 0; ii < secCnt; ++ii) {
+            Section sec;
+            sec.id = NlistBinary::getU32(p);
+            sec.param = NlistBinary::getU32(p + 4);
+            sec.count = NlistBinary::getU64(p + 8);
+            sec.offset = NlistBinary::getU64(p + 16);
+            sec.bytes = NlistBinary::getU64(p + 24);
+            p += NlistBinary::SectionBytes;
+            if (sec.offset > data_.size() ||
+                    sec.bytes > data_.size() - sec.offset) {
+                return fail("section extends past the end of the file");
+            }
+            const uint64_t itemBytes = NlistBinary::itemBytes(sec.id);
+            if (0 != itemBytes && (sec.count > UINT64_MAX / itemBytes ||
+                    sec.bytes != sec.count * itemBytes)) {
+                return fail("section size does not match its count");
+            }
+            secs_.push_back(sec);
+        }
+        // find the known sections. Unknown ids are skipped.
+        for (size_t ii = 0; ii < secs_.size(); ++ii) {
+            const Section *sec = &secs_[ii];
+            switch (sec->id) {
+            case NlistBinary::Header:           header_ = sec; break;
+            case NlistBinary::NodeXY:           nodeXY_ = sec; break;
+            case NlistBinary::NodeAttr:         nodeAttr_ = sec; break;
+            case NlistBinary::NodeNborOffsets:  nborOffsets_ = sec; break;
+            case NlistBinary::NodeNbors:        nbors_ = sec; break;
+            case NlistBinary::Faces:            faces_ = sec; break;
+            case NlistBinary::Geometry:         geometry_ = sec; break;
+            }
+        }
+        if (0 == header_ || 0 == nodeXY_ || 0 == nodeAttr_ ||
+                0 == nborOffsets_ || 0 == nbors_ || 0 == faces_ ||
+                0 == geometry_) {
+            return fail("missing section");
+        }
+        // The accessors index the items with uint32_t
+        if (nodeXY_->count >= UINT32_MAX || faces_->count > UINT32_MAX ||
+                geometry_->count > UINT32_MAX) {
+            return fail("too many items for 32-bit indices");
+        }
+        if (nodeAttr_->count != nodeXY_->count ||
+                nborOffsets_->count != nodeXY_->count + 1 ||
+                0 != nborOffset(0) ||
+                nbors_->count != nborOffset(nodeCount())) {
+            return fail("inconsistent NODES sections");
+        }
+        for (uint32_t ndx = 0; ndx < nodeCount(); ++ndx) {
+            if (nborOffset(ndx) > nborOffset(ndx + 1)) {
+                return fail("invalid neighbor offsets");
+            }
+        }
+        // Checked once here so nbor() and faceVert() need no checks
+        for (uint64_t ii = 0; ii < nbors_->count; ++ii) {
+            const char *v = data(*nbors_) + size_t(ii) * 4;
+            if (NlistBinary::getU32(v) >= nodeCount()) {
+                return fail("neighbor index out of range");
+            }
+        }
+        for (uint64_t ii = 0; ii < faces_->count * 3; ++ii) {
+            const char *v = data(*faces_) + size_t(ii) * 4;
+            if (NlistBinary::getU32(v) >= nodeCount()) {
+                return fail("face vertex index out of range");
+            }
+        }
+        error_.clear();
+        return true;
+    }
+
+    bool fail(const char *msg)
+    {
+        error_ = msg;
+        return false;
+    }
+
+    const char* data(const Section &sec) const {
+        return data_.data() + size_t(sec.offset); }
+
+    uint32_t nborOffset(const uint32_t ndx) const {
+        return NlistBinary::getU32(data(*nborOffsets_) + size_t(ndx) * 4); }
+
+private:
+
+    // The whole file
+    std::vector<char>   data_;
+
+    // The section table
+    SectionArray1       secs_;
+
+    // The known sections in secs_
+    const Section *     header_;
+    const Section *     nodeXY_;
+    const Section *     nodeAttr_;
+    const Section *     nborOffsets_;
+    const Section *     nbors_;
+    const Section *     faces_;
+    const Section *     geometry_;
+
+    // The last read() error
+    std::string         error_;
+};
+
+#endif // _NLISTBINARY_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,625 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * class NlistFormat
+ *
+ * Fixed-width number formatting for the .nlist writers. The output is byte
+ * identical to the printf conversions "%<w>d", "%<w>.<p>E" (p <= 14) and
+ * "%g" as produced by a C runtime that rounds exactly (e.g. glibc).
+ *
+ * Integers are formatted two digits at a time from a digit pair table.
+ *
+ * Reals are scaled by a cached power of ten (64-bit mantissa) so that the
+ * product has 19 significant digits. The product is within +/-2 units of the
+ * exact value, so the requested digits can be rounded directly unless the
+ * discarded digits are within a few units of a rounding tie. Those rare
+ * values, and non-finite or denormal values, are formatted with snprintf.
+ *
+ * With NLIST_FORMAT_PRINTF defined, every field is formatted with snprintf
+ * and the printf conversion above. tools/harness builds the plugin that way
+ * to write its golden files.
+ *
+ ***************************************************************************/
+
+#ifndef _NLISTFORMAT_H_
+#define _NLISTFORMAT_H_
+
+#include<cassert>
+#include<cstdio>
+#include<cstring>
+#include<stdint.h>
+#include<vector>
+
+
+class NlistFormat {
+public:
+
+    enum {
+        // Max chars written by intField() beyond its field width
+        MaxIntChars = 11,
+        // Max chars written by expField() beyond its field width
+        MaxExpChars = 32,
+        // Max chars written by genField()
+        MaxGenChars = 32
+    };
+
+    // Writes val as "%<width>d" to p. Returns the end of the written chars.
+    // The output is NOT null terminated.
+    static char* intField(char *p, const int val, const int width)
+    {
+#if defined(NLIST_FORMAT_PRINTF)
+        return printfField(p, "%*d", width, val);
+#endif
+        char tmp[MaxIntChars];
+        char * const tmpEnd = tmp + MaxIntChars;
+        char *t = tmpEnd;
+        uint32_t u = (val < 0) ? (0u - uint32_t(val)) : uint32_t(val);
+        while (u >= 100) {
+            const uint32_t pair = (u % 100) * 2;
+            u /= 100;
+            *--t = digitPairs()[pair + 1];
+            *--t = digitPairs()[pair];
+        }
+        if (u >= 10) {
+            *--t = digitPairs()[u * 2 + 1];
+            *--t = digitPairs()[u * 2];
+        }
+        else {
+            *--t = char('0' + u);
+        }
+        if (val < 0) {
+            *--t = '-';
+        }
+        return padCopy(p, t, tmpEnd, width);
+    }
+
+    // Writes val right-aligned in exactly width chars to p. Same as
+    // intField() for a non-negative val with at most width digits, but
+    // without the copy from a temporary. Returns p + width.
+    static char* fixedUIntField(char *p, uint32_t val, const int width)
+    {
+#if defined(NLIST_FORMAT_PRINTF)
+        return printfField(p, "%*u", width, val);
+#endif
+        char *t = p + width;
+        while (val >= 100) {
+            const uint32_t pair = (val % 100) * 2;
+            val /= 100;
+            *--t = digitPairs()[pair + 1];
+            *--t = digitPairs()[pair];
+        }
+        if (val >= 10) {
+            *--t = digitPairs()[val * 2 + 1];
+            *--t = digitPairs()[val * 2];
+        }
+        else {
+            *--t = char('0' + val);
+        }
+        assert(t >= p);
+        while (t > p) {
+            *--t = ' ';
+        }
+        return p + width;
+    }
+
+    // Returns the .nlist character of a material id ('0'-'9', 'A'-'Z' or '?')
+    static char matIdChar(const int matId)
+    {
+        static const char idMap[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        return (matId < 0 || matId > 35) ? '?' : idMap[matId];
+    }
+
+    // Writes val as "%<width>.<prec>E" to p. Returns the end of the written
+    // chars. The output is NOT null terminated.
+    static char* expField(char *p, const double val, const int width,
+        const int prec)
+    {
+        assert(prec >= 0 && prec <= MaxPrec);
+#if defined(NLIST_FORMAT_PRINTF)
+        return fallback(p, val, width, prec);
+#endif
+        char tmp[MaxExpChars];
+        char *t = tmp;
+        int exp10 = 0;
+        uint64_t sig = 0;
+        bool isNeg = false;
+        if (!digits(val, prec, sig, exp10, isNeg)) {
+            // cannot be done exactly with a cached power - use the runtime
+            return fallback(p, val, width, prec);
+        }
+
+        if (isNeg) {
+            *t++ = '-';
+        }
+
+        // sig has exactly prec + 1 digits
+        char dig[MaxPrec + 1];
+        for (int ii = prec; ii >= 0; --ii) {
+            dig[ii] = char('0' + (sig % 10));
+            sig /= 10;
+        }
+        *t++ = dig[0];
+        if (prec > 0) {
+            *t++ = '.';
+            memcpy(t, dig + 1, size_t(prec));
+            t += prec;
+        }
+
+        *t++ = 'E';
+        if (exp10 < 0) {
+            *t++ = '-';
+            exp10 = -exp10;
+        }
+        else {
+            *t++ = '+';
+        }
+        if (exp10 >= 100) {
+            *t++ = char('0' + exp10 / 100);
+            exp10 %= 100;
+        }
+        *t++ = digitPairs()[exp10 * 2];
+        *t++ = digitPairs()[exp10 * 2 + 1];
+
+        p = padCopy(p, tmp, t, width);
+#if defined(DEBUG)
+        verify(p, val, width, prec);
+#endif
+        return p;
+    }
+
+    // Writes val as "%g" to p. Returns the end of the written chars. The
+    // output is NOT null terminated.
+    static char* genField(char *p, const double val)
+    {
+        enum { Prec = 6 }; // the "%g" default precision
+#if defined(NLIST_FORMAT_PRINTF)
+        return genFallback(p, val);
+#endif
+        int exp10 = 0;
+        uint64_t sig = 0;
+        bool isNeg = false;
+        if (!digits(val, Prec - 1, sig, exp10, isNeg)) {
+            return genFallback(p, val);
+        }
+#if defined(DEBUG)
+        char * const beg = p;
+#endif
+        if (isNeg) {
+            *p++ = '-';
+        }
+
+        // sig has exactly Prec digits (or is 0). "%g" drops trailing zeros.
+        char dig[Prec];
+        for (int ii = Prec - 1; ii >= 0; --ii) {
+            dig[ii] = char('0' + (sig % 10));
+            sig /= 10;
+        }
+        int digCnt = Prec;
+        while (digCnt > 1 && '0' == dig[digCnt - 1]) {
+            --digCnt;
+        }
+
+        if ('0' == dig[0]) {
+            // +/-0.0
+            *p++ = '0';
+        }
+        else if (exp10 < -4 || exp10 >= Prec) {
+            // "%e" style
+            *p++ = dig[0];
+            if (digCnt > 1) {
+                *p++ = '.';
+                memcpy(p, dig + 1, size_t(digCnt - 1));
+                p += digCnt - 1;
+            }
+            *p++ = 'e';
+            if (exp10 < 0) {
+                *p++ = '-';
+                exp10 = -exp10;
+            }
+            else {
+                *p++ = '+';
+            }
+            if (exp10 >= 100) {
+                *p++ = char('0' + exp10 / 100);
+                exp10 %= 100;
+            }
+            *p++ = digitPairs()[exp10 * 2];
+            *p++ = digitPairs()[exp10 * 2 + 1];
+        }
+        else if (exp10 >= 0) {
+            // "%f" style with exp10 + 1 integer digits
+            memcpy(p, dig, size_t(exp10 + 1));
+            p += exp10 + 1;
+            if (digCnt > exp10 + 1) {
+                *p++ = '.';
+                memcpy(p, dig + exp10 + 1, size_t(digCnt - exp10 - 1));
+                p += digCnt - exp10 - 1;
+            }
+        }
+        else {
+            // "%f" style with -exp10 - 1 leading fraction zeros
+            *p++ = '0';
+            *p++ = '.';
+            for (int ii = exp10 + 1; ii < 0; ++ii) {
+                *p++ = '0';
+            }
+            memcpy(p, dig, size_t(digCnt));
+            p += digCnt;
+        }
+#if defined(DEBUG)
+        verifyGen(beg, p, val);
+#endif
+        return p;
+    }
+
+
+private:
+
+    enum {
+        // Max supported expField() precision
+        MaxPrec = 14,
+        // Range of the cached powers of ten
+        MinPow10 = -300,
+        MaxPow10 = 330
+    };
+
+    // A power of ten as mant * 2^exp2 where mant is normalized (top bit set)
+    struct CachedPow10 {
+        uint64_t    mant;
+        int         exp2;
+    };
+
+    typedef std::vector<CachedPow10>    CachedPow10Array1;
+    typedef std::vector<uint32_t>       BigUInt; // little-endian limbs
+
+
+    static const char* digitPairs()
+    {
+        static const char pairs[] =
+            "00010203040506070809" "10111213141516171819"
+            "20212223242526272829" "30313233343536373839"
+            "40414243444546474849" "50515253545556575859"
+            "60616263646566676869" "70717273747576777879"
+            "80818283848586878889" "90919293949596979899";
+        return pairs;
+    }
+
+
+    static char* padCopy(char *p, const char *beg, const char *end,
+        const int width)
+    {
+        const int len = int(end - beg);
+        for (int ii = len; ii < width; ++ii) {
+            *p++ = ' ';
+        }
+        memcpy(p, beg, size_t(len));
+        return p + len;
+    }
+
+
+    static char* fallback(char *p, const double val, const int width,
+        const int prec)
+    {
+        char tmp[MaxExpChars + 64];
+        const int len = snprintf(tmp, sizeof(tmp), "%*.*E", width, prec, val);
+        if (len > 0) {
+            memcpy(p, tmp, size_t(len));
+            p += len;
+        }
+        return p;
+    }
+
+
+    static char* genFallback(char *p, const double val)
+    {
+        char tmp[MaxGenChars + 64];
+        const int len = snprintf(tmp, sizeof(tmp), "%g", val);
+        if (len > 0) {
+            memcpy(p, tmp, size_t(len));
+            p += len;
+        }
+        return p;
+    }
+
+
+#if defined(NLIST_FORMAT_PRINTF)
+    template<typename T>
+    static char* printfField(char *p, const char *fmt, const int width,
+        const T val)
+    {
+        char tmp[MaxIntChars + 64];
+        const int len = snprintf(tmp, sizeof(tmp), fmt, width, val);
+        if (len > 0) {
+            memcpy(p, tmp, size_t(len));
+            p += len;
+        }
+        return p;
+    }
+#endif
+
+
+#if defined(DEBUG)
+    static void verify(const char *end, const double val, const int width,
+        const int prec)
+    {
+        char tmp[MaxExpChars + 64];
+        const int len = snprintf(tmp, sizeof(tmp), "%*.*E", width, prec, val);
+        assert(0 == memcmp(end - len, tmp, size_t(len)));
+        (void)end;
+        (void)len;
+    }
+
+
+    static void verifyGen(const char *beg, const char *end, const double val)
+    {
+        char tmp[MaxGenChars + 64];
+        const int len = snprintf(tmp, sizeof(tmp), "%g", val);
+        assert(len == int(end - beg) && 0 == memcmp(beg, tmp, size_t(len)));
+        (void)beg;
+        (void)end;
+        (void)len;
+    }
+#endif
+
+
+    // Computes the prec + 1 significant decimal digits of |val| (sig) and
+    // its decimal exponent. Returns false if the value must be formatted with
+    // the runtime.
+    static bool digits(const double val, const int prec, uint64_t &sig,
+        int &exp10, bool &isNeg)
+    {
+        uint64_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        isNeg = (0 != (bits >> 63));
+        const int bexp = int((bits >> 52) & 0x7FF);
+        const uint64_t frac = bits & ((uint64_t(1) << 52) - 1);
+        if (0x7FF == bexp || (0 == bexp && 0 != frac)) {
+            // inf, nan or denormal
+            return false;
+        }
+        if (0 == bexp) {
+            // +/-0.0
+            sig = 0;
+            exp10 = 0;
+            return true;
+        }
+
+        // val = f * 2^e2 with f normalized (top bit set)
+        const uint64_t f = (frac | (uint64_t(1) << 52)) << 11;
+        const int e2 = bexp - 1075 - 11;
+
+        // val is in [2^b, 2^(b+1)), so its decimal exponent is est or est+1
+        const int b = bexp - 1023;
+        const int est = floorDiv(b * 78913, 262144); // floor(b * log10(2))
+
+        // scale val to [1e18, 1e19)
+        int k = 17 - est;
+        uint64_t d;
+        if (!scale(f, e2, k, d)) {
+            return false;
+        }
+        if (d < pow10u(18)) {
+            ++k;
+            if (!scale(f, e2, k, d)) {
+                return false;
+            }
+        }
+        if (d < pow10u(18) || d >= pow10u(19)) {
+            // d is off by a unit at a power of ten boundary
+            return false;
+        }
+
+        // round d to prec + 1 digits. d is within +/-2 units of the exact
+        // value. Defer to the runtime if that could change the rounding.
+        const uint64_t div = pow10u(18 - prec);
+        const uint64_t half = div / 2;
+        const uint64_t rem = d % div;
+        sig = d / div;
+        if (rem + 4 > half && rem < half + 4) {
+            return false;
+        }
+        if (rem > half) {
+            ++sig;
+        }
+        exp10 = 18 - k;
+        if (sig == pow10u(prec + 1)) {
+            // rounded up to the next power of ten (9.99... to 10.00...)
+            sig = pow10u(prec);
+            ++exp10;
+        }
+        return true;
+    }
+
+
+    // Computes d = floor(f * 2^e2 * 10^k) using the cached power of ten.
+    // Returns false if k is out of range or d does not fit in 64 bits.
+    static bool scale(const uint64_t f, const int e2, const int k,
+        uint64_t &d)
+    {
+        if (k < MinPow10 || k > MaxPow10) {
+            return false;
+        }
+        const CachedPow10 &c = cachedPow10s()[size_t(k - MinPow10)];
+        uint64_t hi;
+        uint64_t lo;
+        mul64(f, c.mant, hi, lo);
+        const int shift = -(e2 + c.exp2);
+        if (shift >= 128 || shift <= 0) {
+            return false;
+        }
+        if (shift >= 64) {
+            d = hi >> (shift - 64);
+        }
+        else if (0 != (hi >> shift)) {
+            return false; // overflow
+        }
+        else {
+            d = (hi << (64 - shift)) | (lo >> shift);
+        }
+        return true;
+    }
+
+
+    static void mul64(const uint64_t a, const uint64_t b, uint64_t &hi,
+        uint64_t &lo)
+    {
+        const uint64_t Mask32 = 0xFFFFFFFFu;
+        const uint64_t a0 = a & Mask32;
+        const uint64_t a1 = a >> 32;
+        const uint64_t b0 = b & Mask32;
+        const uint64_t b1 = b >> 32;
+        const uint64_t p00 = a0 * b0;
+        const uint64_t p01 = a0 * b1;
+        const uint64_t p10 = a1 * b0;
+        const uint64_t p11 = a1 * b1;
+        const uint64_t mid = (p00 >> 32) + (p01 & Mask32) + (p10 & Mask32);
+        lo = (mid << 32) | (p00 & Mask32);
+        hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    }
+
+
+    static int floorDiv(const int num, const int den)
+    {
+        return (num >= 0) ? (num / den) : -((-num + den - 1) / den);
+    }
+
+
+    static uint64_t pow10u(const int n)
+    {
+        static const uint64_t p10[] = {
+            1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+            10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+            100000000000ull, 1000000000000ull, 10000000000000ull,
+            100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+            100000000000000000ull, 1000000000000000000ull,
+            10000000000000000000ull };
+        assert(n >= 0 && n <= 19);
+        return p10[n];
+    }
+
+
+    // The table of 10^MinPow10 .. 10^MaxPow10. Built once with exact big
+    // integer arithmetic.
+    static const CachedPow10Array1& cachedPow10s()
+    {
+        static const CachedPow10Array1 table = buildCachedPow10s();
+        return table;
+    }
+
+
+    static CachedPow10Array1 buildCachedPow10s()
+    {
+        CachedPow10Array1 ret(size_t(MaxPow10 - MinPow10 + 1));
+
+        // 10^k for k >= 0
+        BigUInt big(1, 1);
+        for (int k = 0; k <= MaxPow10; ++k) {
+            if (k > 0) {
+                bigMulSmall(big, 10);
+            }
+            ret[size_t(k - MinPow10)] = bigTop64(big, 0);
+        }
+
+        // 10^k for k < 0 as floor(2^M / 10^-k) * 2^-M. Repeated floor
+        // division by 10 is exact (floor(floor(a/b)/c) == floor(a/(b*c))).
+        const int M = 64 + 64 + (-MinPow10 * 3402) / 1024; // log2(10) < 3.3222
+        big.assign(size_t(M / 32 + 1), 0);
+        big.back() = uint32_t(1) << (M % 32);
+        for (int k = -1; k >= MinPow10; --k) {
+            bigDivSmall(big, 10);
+            ret[size_t(k - MinPow10)] = bigTop64(big, M);
+        }
+        return ret;
+    }
+
+
+    static void bigMulSmall(BigUInt &big, const uint32_t m)
+    {
+        uint64_t carry = 0;
+        for (size_t ii = 0; ii < big.size(); ++ii) {
+            const uint64_t v = uint64_t(big[ii]) * m + carry;
+            big[ii] = uint32_t(v);
+            carry = v >> 32;
+        }
+        if (0 != carry) {
+            big.push_back(uint32_t(carry));
+        }
+    }
+
+
+    static void bigDivSmall(BigUInt &big, const uint32_t den)
+    {
+        uint64_t rem = 0;
+        for (size_t ii = big.size(); ii > 0; --ii) {
+            const uint64_t v = (rem << 32) | big[ii - 1];
+            big[ii - 1] = uint32_t(v / den);
+            rem = v % den;
+        }
+        while (!big.empty() && 0 == big.back()) {
+            big.pop_back();
+        }
+    }
+
+
+    // Returns the top 64 bits of big (rounded to nearest) as a CachedPow10
+    // scaled by 2^-scaleExp2.
+    static CachedPow10 bigTop64(const BigUInt &big, const int scaleExp2)
+    {
+        assert(!big.empty() && 0 != big.back());
+        int bitLen = int(big.size() - 1) * 32;
+        for (uint32_t top = big.back(); 0 != top; top >>= 1) {
+            ++bitLen;
+        }
+
+        CachedPow10 ret;
+        uint64_t mant = 0;
+        bool roundUp = false;
+        for (int bit = bitLen - 1; bit >= bitLen - 65 && bit >= 0; --bit) {
+            const bool isSet = 0 != ((big[size_t(bit / 32)] >> (bit % 32)) & 1);
+            if (bit >= bitLen - 64) {
+                mant = (mant << 1) | (isSet ? 1 : 0);
+            }
+            else {
+                roundUp = isSet;
+            }
+        }
+        int exp2 = bitLen - 64;
+        if (bitLen < 64) {
+            mant <<= (64 - bitLen);
+        }
+        if (roundUp) {
+            if (~uint64_t(0) == mant) {
+                mant = uint64_t(1) << 63;
+                ++exp2;
+            }
+            else {
+                ++mant;
+            }
+        }
+        ret.mant = mant;
+        ret.exp2 = exp2 - scaleExp2;
+        return ret;
+    }
+};
+
+#endif // _NLISTFORMAT_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
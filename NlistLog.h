@@ -0,0 +1,422 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * class NlistLog
+ * class NlistLogReader
+ *
+ * The CreateLog debug log. The text log is a Tcl script of node and edge
+ * proc calls:
+ *
+ *   node nodeId {x y z} matId matConflict isBndry zoneId zoneConflict {nbors}
+ *   edge ndx0 {x0 y0 z0} ndx1 {x1 y1 z1}
+ *
+ * nodeId and nbors are 1-based, ndx0 and ndx1 are 0-based. Reals are "%g".
+ * Any other line (comments, set commands) is written as is.
+ *
+ * The binary log holds the same records in a compact little-endian form.
+ * nlistlog2tcl converts it to the text log.
+ *
+ *   File header (16 bytes)
+ *     char[8]  magic "NLISTLOG"
+ *     uint32   version (NlistLog::Version)
+ *     uint32   0
+ *
+ *   Records (8 byte record header followed by bytes of record data)
+ *     uint32   record id (NlistLog::RecordId)
+ *     uint32   bytes
+ *
+ *     Text     char[bytes]     one or more complete text lines
+ *     Node     uint32          0-based node index
+ *              float64[3]      x, y, z
+ *              int32           matId
+ *              int32           zoneId
+ *              uint32          NlistBinary::NodeFlags
+ *              uint32          neighbor count
+ *              uint32[count]   0-based neighbor indices
+ *     Edge     uint32          0-based index of node 0
+ *              float64[3]      x0, y0, z0
+ *              uint32          0-based index of node 1
+ *              float64[3]      x1, y1, z1
+ *
+ * Unknown record ids must be skipped by readers. This file does not depend
+ * on the PluginSDK.
+ *
+ ***************************************************************************/
+
+#ifndef _NLISTLOG_H_
+#define _NLISTLOG_H_
+
+#include "NlistBinary.h"
+#include "NlistFormat.h"
+
+#include<cstdio>
+#include<cstring>
+#include<stdint.h>
+#include<string>
+#include<vector>
+
+
+class NlistLog {
+public:
+
+    enum {
+        // The current format version
+        Version = 1,
+        // Bytes in the file header
+        FileHeaderBytes = 16,
+        // Bytes in a record header
+        RecordHeaderBytes = 8,
+        // Bytes in an Edge record (with its header)
+        EdgeRecordBytes = RecordHeaderBytes + 56,
+        // Max chars of an edge text line
+        EdgeLineMaxChars = 2 * (NlistFormat::MaxIntChars + 3 +
+            3 * (NlistFormat::MaxGenChars + 1)) + 16
+    };
+
+    enum RecordId {
+        Text = 1,
+        Node = 2,
+        Edge = 3
+    };
+
+    // The data of one node record
+    struct NodeData {
+        uint32_t            ndx;
+        double              xyz[3];
+        int32_t             matId;
+        int32_t             zoneId;
+        uint32_t            flags;
+        uint32_t            nborCnt;
+        // nborCnt 0-based neighbor indices
+        const uint32_t *    nbors;
+    };
+
+    // The data of one edge record
+    struct EdgeData {
+        uint32_t    ndx0;
+        double      xyz0[3];
+        uint32_t    ndx1;
+        double      xyz1[3];
+    };
+
+
+    static const char* magic()
+    {
+        return "NLISTLOG";
+    }
+
+    // Writes the file header (FileHeaderBytes chars) to p. Returns the end
+    // of the written chars.
+    static char* putFileHeader(char *p)
+    {
+        memcpy(p, magic(), 8);
+        p = NlistBinary::putU32(p + 8, Version);
+        return NlistBinary::putU32(p, 0);
+    }
+
+    // Writes a Text record of the cnt chars of text to p
+    // (RecordHeaderBytes + cnt chars). Returns the end of the written chars.
+    static char* putText(char *p, const char *text, const size_t cnt)
+    {
+        p = NlistBinary::putU32(p, Text);
+        p = NlistBinary::putU32(p, uint32_t(cnt));
+        memcpy(p, text, cnt);
+        return p + cnt;
+    }
+
+    // The bytes of a Node record (with its header) of nborCnt neighbors
+    static size_t nodeRecordBytes(const size_t nborCnt)
+    {
+        return RecordHeaderBytes + 44 + 4 * nborCnt;
+    }
+
+    // Writes a Node record to p (nodeRecordBytes(nborCnt) chars). The
+    // neighbor indices are read from nbors[0..nborCnt). Returns the end of
+    // the written chars.
+    template<typename NborIter>
+    static char* putNode(char *p, const uint32_t ndx, const double xyz[3],
+        const int32_t matId, const int32_t zoneId, const uint32_t flags,
+        const uint32_t nborCnt, NborIter nbors)
+    {
+        p = NlistBinary::putU32(p, Node);
+        p = NlistBinary::putU32(p, uint32_t(nodeRecordBytes(nborCnt) -
+            RecordHeaderBytes));
+        p = NlistBinary::putU32(p, ndx);
+        p = NlistBinary::putF64(p, xyz[0]);
+        p = NlistBinary::putF64(p, xyz[1]);
+        p = NlistBinary::putF64(p, xyz[2]);
+        p = NlistBinary::putI32(p, matId);
+        p = NlistBinary::putI32(p, zoneId);
+        p = NlistBinary::putU32(p, flags);
+        p = NlistBinary::putU32(p, nborCnt);
+        for (uint32_t ii = 0; ii < nborCnt; ++ii, ++nbors) {
+            p = NlistBinary::putU32(p, uint32_t(*nbors));
+        }
+        return p;
+    }
+
+    // Max chars of a node text line of nborCnt neighbors
+    static size_t nodeLineMaxChars(const size_t nborCnt)
+    {
+        return 6 * NlistFormat::MaxIntChars + 3 * NlistFormat::MaxGenChars +
+            32 + nborCnt * (NlistFormat::MaxIntChars + 1);
+    }
+
+    // Writes a node text line to p (at most nodeLineMaxChars(nborCnt)
+    // chars). Same as
+    //   writef("node %d {%g %g %g} %d %d %d %d %d {", ...)
+    // followed by the space separated 1-based neighbor indices and "}\n".
+    // Returns the end of the written chars.
+    template<typename NborIter>
+    static char* formatNode(char *p, const uint32_t ndx, const double xyz[3],
+        const int32_t matId, const int32_t zoneId, const uint32_t flags,
+        const uint32_t nborCnt, NborIter nbors)
+    {
+        memcpy(p, "node ", 5);
+        p = NlistFormat::intField(p + 5, int(ndx + 1), 0);
+        p = formatPoint(p, xyz);
+        *p++ = ' ';
+        p = NlistFormat::intField(p, int(matId), 0);
+        *p++ = ' ';
+        *p++ = flagChar(flags, NlistBinary::NodeMatConflict);
+        *p++ = ' ';
+        *p++ = flagChar(flags, NlistBinary::NodeBndry);
+        *p++ = ' ';
+        p = NlistFormat::intField(p, int(zoneId), 0);
+        *p++ = ' ';
+        *p++ = flagChar(flags, NlistBinary::NodeZoneConflict);
+        *p++ = ' ';
+        *p++ = '{';
+        for (uint32_t ii = 0; ii < nborCnt; ++ii, ++nbors) {
+            if (0 != ii) {
+                *p++ = ' ';
+            }
+            p = NlistFormat::intField(p, int(*nbors + 1), 0);
+        }
+        *p++ = '}';
+        *p++ = '\n';
+        return p;
+    }
+
+    // Writes an Edge record to p (EdgeRecordBytes chars). Returns the end of
+    // the written chars.
+    static char* putEdge(char *p, const uint32_t ndx0, const double xyz0[3],
+        const uint32_t ndx1, const double xyz1[3])
+    {
+        p = NlistBinary::putU32(p, Edge);
+        p = NlistBinary::putU32(p, EdgeRecordBytes - RecordHeaderBytes);
+        p = NlistBinary::putU32(p, ndx0);
+        p = NlistBinary::putF64(p, xyz0[0]);
+        p = NlistBinary::putF64(p, xyz0[1]);
+        p = NlistBinary::putF64(p, xyz0[2]);
+        p = NlistBinary::putU32(p, ndx1);
+        p = NlistBinary::putF64(p, xyz1[0]);
+        p = NlistBinary::putF64(p, xyz1[1]);
+        return NlistBinary::putF64(p, xyz1[2]);
+    }
+
+    // Writes an edge text line to p (at most EdgeLineMaxChars chars). Same
+    // as writef("edge %d {%g %g %g} %d {%g %g %g}\n", ...). Returns the end
+    // of the written chars.
+    static char* formatEdge(char *p, const uint32_t ndx0,
+        const double xyz0[3], const uint32_t ndx1, const double xyz1[3])
+    {
+        memcpy(p, "edge ", 5);
+        p = NlistFormat::intField(p + 5, int(ndx0), 0);
+        p = formatPoint(p, xyz0);
+        *p++ = ' ';
+        p = NlistFormat::intField(p, int(ndx1), 0);
+        p = formatPoint(p, xyz1);
+        *p++ = '\n';
+        return p;
+    }
+
+private:
+
+    // Writes " {x y z}" to p
+    static char* formatPoint(char *p, const double xyz[3])
+    {
+        *p++ = ' ';
+        *p++ = '{';
+        p = NlistFormat::genField(p, xyz[0]);
+        *p++ = ' ';
+        p = NlistFormat::genField(p, xyz[1]);
+        *p++ = ' ';
+        p = NlistFormat::genField(p, xyz[2]);
+        *p++ = '}';
+        return p;
+    }
+
+    static char flagChar(const uint32_t flags, const uint32_t bit)
+    {
+        return (0 != (flags & bit)) ? '1' : '0';
+    }
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Reads a binary log file into memory and iterates its records
+class NlistLogReader {
+public:
+    NlistLogReader() :
+        data_(),
+        pos_(0),
+        nbors_(),
+        error_()
+    {
+    }
+
+    ~NlistLogReader()
+    {
+    }
+
+    // Reads the file and validates its header. Returns false and sets
+    // error() if the file cannot be read or is not a binary log file.
+    bool read(const char *fileName)
+    {
+        data_.clear();
+        pos_ = 0;
+        FILE *fp = fopen(fileName, "rb");
+        if (0 == fp) {
+            return fail("cannot open file");
+        }
+        char buf[65536];
+        size_t cnt;
+        while (0 != (cnt = fread(buf, 1, sizeof(buf), fp))) {
+            data_.insert(data_.end(), buf, buf + cnt);
+        }
+        const bool hadError = (0 != ferror(fp));
+        fclose(fp);
+        if (hadError) {
+            return fail("read error");
+        }
+        if (data_.size() < size_t(NlistLog::FileHeaderBytes) ||
+                0 != memcmp(data_.data(), NlistLog::magic(), 8)) {
+            return fail("not a binary log file");
+        }
+        if (NlistLog::Version != NlistBinary::getU32(data_.data() + 8)) {
+            return fail("unsupported version");
+        }
+        pos_ = NlistLog::FileHeaderBytes;
+        error_.clear();
+        return true;
+    }
+
+    // Gets the next record. Returns false at the end of the file or if the
+    // record is invalid (error() is set). The record data is valid until
+    // the next read().
+    bool next(uint32_t &id, const char *&data, uint32_t &bytes)
+    {
+        if (pos_ >= data_.size()) {
+            return false;
+        }
+        if (data_.size() - pos_ < size_t(NlistLog::RecordHeaderBytes)) {
+            return fail("truncated record header");
+        }
+        id = NlistBinary::getU32(data_.data() + pos_);
+        bytes = NlistBinary::getU32(data_.data() + pos_ + 4);
+        pos_ += NlistLog::RecordHeaderBytes;
+        if (data_.size() - pos_ < size_t(bytes)) {
+            return fail("record extends past the end of the file");
+        }
+        data = data_.data() + pos_;
+        pos_ += bytes;
+        return true;
+    }
+
+    // Decodes the data of a Node record
+    bool getNode(const char *data, const uint32_t bytes,
+        NlistLog::NodeData &node)
+    {
+        if (bytes < 44) {
+            return fail("truncated node record");
+        }
+        node.ndx = NlistBinary::getU32(data);
+        node.xyz[0] = NlistBinary::getF64(data + 4);
+        node.xyz[1] = NlistBinary::getF64(data + 12);
+        node.xyz[2] = NlistBinary::getF64(data + 20);
+        node.matId = NlistBinary::getI32(data + 28);
+        node.zoneId = NlistBinary::getI32(data + 32);
+        node.flags = NlistBinary::getU32(data + 36);
+        node.nborCnt = NlistBinary::getU32(data + 40);
+        if (size_t(bytes) != NlistLog::nodeRecordBytes(node.nborCnt) -
+                NlistLog::RecordHeaderBytes) {
+            return fail("node record size does not match its neighbors");
+        }
+        nbors_.resize(node.nborCnt);
+        for (uint32_t ii = 0; ii < node.nborCnt; ++ii) {
+            nbors_[ii] = NlistBinary::getU32(data + 44 + 4 * ii);
+        }
+        node.nbors = nbors_.data();
+        return true;
+    }
+
+    // Decodes the data of an Edge record
+    bool getEdge(const char *data, const uint32_t bytes,
+        NlistLog::EdgeData &edge)
+    {
+        if (size_t(bytes) != size_t(NlistLog::EdgeRecordBytes -
+                NlistLog::RecordHeaderBytes)) {
+            return fail("invalid edge record size");
+        }
+        edge.ndx0 = NlistBinary::getU32(data);
+        edge.xyz0[0] = NlistBinary::getF64(data + 4);
+        edge.xyz0[1] = NlistBinary::getF64(data + 12);
+        edge.xyz0[2] = NlistBinary::getF64(data + 20);
+        edge.ndx1 = NlistBinary::getU32(data + 28);
+        edge.xyz1[0] = NlistBinary::getF64(data + 32);
+        edge.xyz1[1] = NlistBinary::getF64(data + 40);
+        edge.xyz1[2] = NlistBinary::getF64(data + 48);
+        return true;
+    }
+
+    const char* error() const {
+        return error_.c_str(); }
+
+private:
+
+    bool fail(const char *msg)
+    {
+        error_ = msg;
+        return false;
+    }
+
+private:
+
+    // The whole file
+    std::vector<char>       data_;
+
+    // The offset of the next record in data_
+    size_t                  pos_;
+
+    // The neighbors of the last getNode()
+    std::vector<uint32_t>   nbors_;
+
+    // The last read() or next() error
+    std::string             error_;
+};
+
+#endif // _NLISTLOG_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
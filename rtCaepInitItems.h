@@ -27,7 +27,7 @@
         PWP_TRUE,                   /* PWP_BOOL allowedVolumeConditions */
 
         PWP_TRUE,                   /* PWP_BOOL allowedFileFormatASCII */
-        PWP_FALSE,                  /* PWP_BOOL allowedFileFormatBinary */
+        PWP_TRUE,                   /* PWP_BOOL allowedFileFormatBinary */
         PWP_FALSE,                  /* PWP_BOOL allowedFileFormatUnformatted */
 
         PWP_FALSE,                  /* PWP_BOOL allowedDataPrecisionSingle */
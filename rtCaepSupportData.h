@@ -24,8 +24,16 @@
 //    { "NOTUSED", 1 },
 //};
 
+// The compressed extensions are only offered if their codec is built in
+// (see StreamCompressor)
 const char *CaeUnsUMCPSEGFileExt[] = {
     "nlist"
+#if defined(UMCPSEG_HAVE_ZLIB)
+    , "nlist.gz"
+#endif
+#if defined(UMCPSEG_HAVE_ZSTD)
+    , "nlist.zst"
+#endif
 };
 
 #endif /* _RTCAEPSUPPORTDATA_H_ */
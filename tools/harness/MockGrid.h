@@ -0,0 +1,573 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * class MockGrid
+ *
+ * A synthetic 2D unstructured grid held in memory. It backs the harness
+ * stand-in of the grid model API (sdk/CaeUnsGridModel.h).
+ *
+ * The vertices are an nx by ny lattice on the unit square. Interior
+ * vertices are jittered so the coordinates have many significant digits.
+ * With MockCoordsTies the lattice is instead scaled so the coordinates are
+ * small, negative or on a decimal rounding tie of the .nlist conversions
+ * (see vertex()).
+ * Each lattice cell is a quad or is split into two tris along the diagonal
+ * from its lower left to its upper right vertex.
+ *
+ * The cell columns are split into blockCnt vertical strips. Each strip is a
+ * block. The elements are numbered block by block and row by row within a
+ * block, so the model element indices are the block elements concatenated
+ * in block order. With MockOrderRows the elements are instead numbered row
+ * by row across all blocks, so the blocks are not contiguous. Block b has a
+ * VC with material (b % materialCnt) and zone b. With materialCnt 0 no block
+ * has a VC.
+ *
+ * The 4 sides of the square (bottom, right, top, left) are domains. With
+ * useBCs, side d has a BC with material ((materialCnt + d) % 36) and zone
+ * 100 + d.
+ *
+ * Edges inside a block are interior faces, edges between blocks are
+ * connection faces and edges on the sides are boundary faces. The faces are
+ * streamed row by row, or with shuffleFaces in a scattered order that gives
+ * every node its neighbors in an irregular order.
+ *
+ ***************************************************************************/
+
+#ifndef _MOCKGRID_H_
+#define _MOCKGRID_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<map>
+#include<string>
+#include<vector>
+
+
+// The cell types of a MockGrid
+enum MockElemMix {
+    MockElemTris,   // every cell is two tris
+    MockElemQuads,  // every cell is a quad
+    MockElemMixed   // runs of MixedRun quad cells alternate with tri cells
+};
+
+// The element numbering of a MockGrid
+enum MockElemOrder {
+    MockOrderBlocks,    // block by block
+    MockOrderRows       // row by row across all blocks
+};
+
+// The vertex coordinates of a MockGrid
+enum MockCoords {
+    MockCoordsJittered, // the unit square with jittered interior vertices
+    MockCoordsTies      // rounding ties and negative exponents
+};
+
+struct MockGridConfig {
+    MockGridConfig() :
+        nx(101),
+        ny(101),
+        mix(MockElemMixed),
+        order(MockOrderBlocks),
+        coords(MockCoordsJittered),
+        blockCnt(4),
+        materialCnt(2),
+        useBCs(true),
+        shuffleFaces(false)
+    {
+    }
+
+    PWP_UINT32      nx;             // vertices in x (>= 2)
+    PWP_UINT32      ny;             // vertices in y (>= 2)
+    MockElemMix     mix;
+    MockElemOrder   order;
+    MockCoords      coords;
+    PWP_UINT32      blockCnt;       // 1 to nx - 1
+    PWP_UINT32      materialCnt;    // 0 to 36
+    bool            useBCs;
+    bool            shuffleFaces;   // stream the faces in a scattered order
+};
+
+
+class MockGrid {
+public:
+
+    enum {
+        // Cells per run of quads in a MockElemMixed grid
+        MixedRun = 8,
+        // Number of domains (the sides of the square)
+        DomainCnt = 4
+    };
+
+    MockGrid() :
+        cfg_(),
+        colBlk_(),
+        blkFirstCol_(),
+        blkElemCnt_(),
+        cellElem_(),
+        elemCode_(),
+        triCells_(),
+        triCnt_(0),
+        quadCnt_(0),
+        attrs_()
+    {
+    }
+
+    ~MockGrid()
+    {
+    }
+
+    // Builds the grid. Returns false if cfg is invalid.
+    bool        create(const MockGridConfig &cfg) {
+                    if (cfg.nx < 2 || cfg.ny < 2 || 0 == cfg.blockCnt ||
+                            cfg.blockCnt > cfg.nx - 1 ||
+                            cfg.materialCnt > 36 ||
+                            double(cfg.nx) * cfg.ny >= 4294967295.0 / 8) {
+                        return false;
+                    }
+                    cfg_ = cfg;
+                    const PWP_UINT32 cx = cellsX();
+                    const PWP_UINT32 cy = cellsY();
+                    colBlk_.resize(cx);
+                    blkFirstCol_.resize(cfg.blockCnt + 1);
+                    for (PWP_UINT32 b = 0; b <= cfg.blockCnt; ++b) {
+                        blkFirstCol_[b] = PWP_UINT32(PWP_UINT64(b) * cx /
+                            cfg.blockCnt);
+                    }
+                    for (PWP_UINT32 b = 0; b < cfg.blockCnt; ++b) {
+                        for (PWP_UINT32 i = blkFirstCol_[b];
+                                i < blkFirstCol_[b + 1]; ++i) {
+                            colBlk_[i] = b;
+                        }
+                    }
+                    // number the elements block by block or row by row
+                    cellElem_.resize(size_t(cx) * cy);
+                    elemCode_.clear();
+                    blkElemCnt_.assign(cfg.blockCnt, 0);
+                    triCnt_ = 0;
+                    quadCnt_ = 0;
+                    triCells_.clear();
+                    for (PWP_UINT32 j = 0; j < cy; ++j) {
+                        for (PWP_UINT32 i = 0; i < cx; ++i) {
+                            if (!isQuadCell(i, j)) {
+                                triCells_.push_back(cell(i, j));
+                            }
+                        }
+                    }
+                    if (MockOrderRows == cfg.order) {
+                        for (PWP_UINT32 j = 0; j < cy; ++j) {
+                            for (PWP_UINT32 i = 0; i < cx; ++i) {
+                                addCell(i, j);
+                            }
+                        }
+                    }
+                    else {
+                        for (PWP_UINT32 b = 0; b < cfg.blockCnt; ++b) {
+                            for (PWP_UINT32 j = 0; j < cy; ++j) {
+                                for (PWP_UINT32 i = blkFirstCol_[b];
+                                        i < blkFirstCol_[b + 1]; ++i) {
+                                    addCell(i, j);
+                                }
+                            }
+                        }
+                    }
+                    return true; }
+
+    const MockGridConfig & config() const {
+                    return cfg_; }
+
+    PWP_UINT32  vertexCount() const {
+                    return cfg_.nx * cfg_.ny; }
+
+    PWP_UINT32  elementCount() const {
+                    return PWP_UINT32(elemCode_.size()); }
+
+    PWP_UINT32  triCount() const {
+                    return triCnt_; }
+
+    PWP_UINT32  quadCount() const {
+                    return quadCnt_; }
+
+    PWP_UINT32  blockCount() const {
+                    return cfg_.blockCnt; }
+
+    PWP_UINT32  blockElementCount(const PWP_UINT32 blk) const {
+                    return blkElemCnt_[blk]; }
+
+    // The block of element ndx
+    PWP_UINT32  elementBlock(const PWP_UINT32 ndx) const {
+                    return colBlk_[(elemCode_[ndx] / 4) % cellsX()]; }
+
+    PWP_UINT32  domainCount() const {
+                    return DomainCnt; }
+
+    // Returns false if blk has no VC
+    bool        blockCondition(const PWP_UINT32 blk, PWGM_CONDDATA &cd) const {
+                    const bool ret = (0 != cfg_.materialCnt);
+                    setCondition(cd, "VC", ret ? (blk % cfg_.materialCnt) :
+                        0, blk, ret);
+                    return ret; }
+
+    // Returns false if dom has no BC
+    bool        domainCondition(const PWP_UINT32 dom,
+                    PWGM_CONDDATA &cd) const {
+                    setCondition(cd, "BC", (cfg_.materialCnt + dom) % 36,
+                        100 + dom, cfg_.useBCs);
+                    return cfg_.useBCs; }
+
+    void        vertex(const PWP_UINT32 ndx, PWP_REAL &x, PWP_REAL &y,
+                    PWP_REAL &z) const {
+                    const PWP_UINT32 i = ndx % cfg_.nx;
+                    const PWP_UINT32 j = ndx / cfg_.nx;
+                    z = 0.0;
+                    if (MockCoordsTies == cfg_.coords) {
+                        tieVertex(i, j, x, y);
+                        return;
+                    }
+                    const double hx = 1.0 / (cfg_.nx - 1);
+                    const double hy = 1.0 / (cfg_.ny - 1);
+                    x = i * hx;
+                    y = j * hy;
+                    if (i > 0 && j > 0 && i < cfg_.nx - 1 && j < cfg_.ny - 1) {
+                        // jitter by up to 20% of a cell
+                        x += 0.2 * hx * (jitter(ndx, 1) - 0.5);
+                        y += 0.2 * hy * (jitter(ndx, 2) - 0.5);
+                    } }
+
+    void        element(const PWP_UINT32 ndx, PWGM_ELEMDATA &d) const {
+                    const PWP_UINT32 cell = elemCode_[ndx] / 4;
+                    const PWP_UINT32 i = cell % cellsX();
+                    const PWP_UINT32 j = cell / cellsX();
+                    const PWP_UINT32 v00 = vert(i, j);
+                    const PWP_UINT32 v10 = vert(i + 1, j);
+                    const PWP_UINT32 v11 = vert(i + 1, j + 1);
+                    const PWP_UINT32 v01 = vert(i, j + 1);
+                    memset(&d, 0, sizeof(d));
+                    switch (elemCode_[ndx] % 4) {
+                    case KindQuad:
+                        setElem(d, PWGM_ELEMTYPE_QUAD, v00, v10, v11, v01);
+                        break;
+                    case KindTriLo:
+                        setElem(d, PWGM_ELEMTYPE_TRI, v00, v10, v11, 0);
+                        break;
+                    default:
+                        setElem(d, PWGM_ELEMTYPE_TRI, v00, v11, v01, 0);
+                        break;
+                    } }
+
+    // Streams every edge once to handler. Handler has the streamBegin(),
+    // streamFace() and streamEnd() methods of CaeFaceStreamHandler. Stops
+    // and returns false if a handler call returns 0.
+    template<typename Handler>
+    bool        streamFaces(Handler &handler) const {
+                    const PWP_UINT32 cx = cellsX();
+                    const PWP_UINT32 cy = cellsY();
+                    const PWP_UINT32 nx = cfg_.nx;
+                    const PWP_UINT32 ny = cfg_.ny;
+                    PWGM_BEGINSTREAM_DATA bd;
+                    memset(&bd, 0, sizeof(bd));
+                    bd.model = this;
+                    bd.numBoundaryFaces = 2 * cx + 2 * cy;
+                    bd.numConnections = (cfg_.blockCnt - 1) * cy;
+                    bd.totalNumFaces = cx * ny + nx * cy + triCnt_ / 2;
+                    bd.numInteriorFaces = bd.totalNumFaces -
+                        bd.numBoundaryFaces - bd.numConnections;
+                    bool ret = (0 != handler.streamBegin(bd));
+
+                    PWGM_FACESTREAM_DATA fd;
+                    memset(&fd, 0, sizeof(fd));
+                    fd.model = this;
+                    fd.elemData.type = PWGM_ELEMTYPE_BAR;
+                    fd.elemData.vertCnt = 2;
+                    fd.owner.block.model = this;
+                    fd.owner.domain.model = this;
+
+                    // Face f is streamed k-th. Without shuffleFaces f is k.
+                    const PWP_UINT32 faceCnt = bd.totalNumFaces;
+                    const PWP_UINT64 stride = cfg_.shuffleFaces ?
+                        faceStride(faceCnt) : 1;
+                    PWP_UINT64 f = 0;
+                    for (PWP_UINT32 k = 0; ret && k < faceCnt; ++k) {
+                        setFaceData(fd, PWP_UINT32(f));
+                        fd.face = k;
+                        ret = (0 != handler.streamFace(fd));
+                        f = (f + stride) % faceCnt;
+                    }
+
+                    PWGM_ENDSTREAM_DATA ed;
+                    ed.model = this;
+                    ed.ok = ret ? PWP_TRUE : PWP_FALSE;
+                    ed.userData = 0;
+                    return (0 != handler.streamEnd(ed)) && ret; }
+
+    // Solver attributes returned by the grid model. name=value strings.
+    bool        setAttribute(const char *nameValue) {
+                    const char *eq = strchr(nameValue, '=');
+                    if (0 == eq || eq == nameValue) {
+                        return false;
+                    }
+                    attrs_[std::string(nameValue, eq)] = eq + 1;
+                    return true; }
+
+    // Returns the value of attribute name or null if not set
+    const char* findAttribute(const char *name) const {
+                    std::map<std::string, std::string>::const_iterator it =
+                        attrs_.find(name);
+                    return (attrs_.end() == it) ? 0 : it->second.c_str(); }
+
+private:
+
+    enum ElemKind {
+        KindQuad,   // (v00, v10, v11, v01)
+        KindTriLo,  // (v00, v10, v11)
+        KindTriHi   // (v00, v11, v01)
+    };
+
+    // The sides of a cell
+    enum CellSide {
+        SideBottom,
+        SideRight,
+        SideTop,
+        SideLeft,
+        SideDiag
+    };
+
+    PWP_UINT32  cellsX() const {
+                    return cfg_.nx - 1; }
+
+    PWP_UINT32  cellsY() const {
+                    return cfg_.ny - 1; }
+
+    PWP_UINT32  cell(const PWP_UINT32 i, const PWP_UINT32 j) const {
+                    return j * cellsX() + i; }
+
+    PWP_UINT32  vert(const PWP_UINT32 i, const PWP_UINT32 j) const {
+                    return j * cfg_.nx + i; }
+
+    bool        isQuadCell(const PWP_UINT32 i, const PWP_UINT32 j) const {
+                    switch (cfg_.mix) {
+                    case MockElemQuads: return true;
+                    case MockElemTris:  return false;
+                    default:            break;
+                    }
+                    return 0 == ((i / MixedRun) + j) % 2; }
+
+    // Sets the vertices and the owner and neighbor of face f. The faces are
+    // the horizontal edges row by row, then the vertical edges row by row,
+    // then the diagonals of the tri cells.
+    void        setFaceData(PWGM_FACESTREAM_DATA &fd,
+                    const PWP_UINT32 f) const {
+                    const PWP_UINT32 cx = cellsX();
+                    const PWP_UINT32 cy = cellsY();
+                    const PWP_UINT32 nx = cfg_.nx;
+                    const PWP_UINT32 hCnt = cx * cfg_.ny;
+                    const PWP_UINT32 vCnt = nx * cy;
+                    if (f < hCnt) {
+                        // The owner is the cell above unless the edge is on
+                        // the top side.
+                        const PWP_UINT32 i = f % cx;
+                        const PWP_UINT32 j = f / cx;
+                        const bool isTop = (j == cy);
+                        const PWP_UINT32 own = isTop ? cell(i, j - 1) :
+                            cell(i, j);
+                        const PWP_UINT32 nbr = (isTop || 0 == j) ?
+                            PWP_UINT32_UNDEF : cell(i, j - 1);
+                        fd.elemData.index[0] = isTop ? vert(i + 1, j) :
+                            vert(i, j);
+                        fd.elemData.index[1] = isTop ? vert(i, j) :
+                            vert(i + 1, j);
+                        setFace(fd, own, isTop ? SideTop : SideBottom, nbr,
+                            isTop ? SideBottom : SideTop,
+                            (0 == j) ? 0 : (isTop ? 2 : PWP_UINT32_UNDEF));
+                    }
+                    else if (f < hCnt + vCnt) {
+                        // The owner is the cell to the right unless the edge
+                        // is on the right side.
+                        const PWP_UINT32 i = (f - hCnt) % nx;
+                        const PWP_UINT32 j = (f - hCnt) / nx;
+                        const bool isRight = (i == cx);
+                        const PWP_UINT32 own = isRight ? cell(i - 1, j) :
+                            cell(i, j);
+                        const PWP_UINT32 nbr = (isRight || 0 == i) ?
+                            PWP_UINT32_UNDEF : cell(i - 1, j);
+                        fd.elemData.index[0] = isRight ? vert(i, j) :
+                            vert(i, j + 1);
+                        fd.elemData.index[1] = isRight ? vert(i, j + 1) :
+                            vert(i, j);
+                        setFace(fd, own, isRight ? SideRight : SideLeft,
+                            nbr, isRight ? SideLeft : SideRight,
+                            (0 == i) ? 3 : (isRight ? 1 : PWP_UINT32_UNDEF));
+                    }
+                    else {
+                        const PWP_UINT32 c = triCells_[f - hCnt - vCnt];
+                        const PWP_UINT32 i = c % cx;
+                        const PWP_UINT32 j = c / cx;
+                        fd.elemData.index[0] = vert(i + 1, j + 1);
+                        fd.elemData.index[1] = vert(i, j);
+                        setFace(fd, c, SideDiag, c, SideDiag,
+                            PWP_UINT32_UNDEF);
+                    } }
+
+    // Returns a stride near 0.618 * faceCnt that is coprime to faceCnt, so
+    // (k * stride) % faceCnt visits every face once in a scattered order
+    static PWP_UINT64 faceStride(const PWP_UINT32 faceCnt) {
+                    PWP_UINT64 ret = PWP_UINT64(faceCnt * 0.6180339887) | 1;
+                    while (1 != gcd(ret, faceCnt)) {
+                        ret += 2;
+                    }
+                    return ret; }
+
+    static PWP_UINT64 gcd(PWP_UINT64 a, PWP_UINT64 b) {
+                    while (0 != b) {
+                        const PWP_UINT64 t = a % b;
+                        a = b;
+                        b = t;
+                    }
+                    return a; }
+
+    // Numbers the elements of cell (i, j)
+    void        addCell(const PWP_UINT32 i, const PWP_UINT32 j) {
+                    const PWP_UINT32 cell = j * cellsX() + i;
+                    cellElem_[cell] = PWP_UINT32(elemCode_.size());
+                    if (isQuadCell(i, j)) {
+                        elemCode_.push_back(cell * 4 + KindQuad);
+                        ++quadCnt_;
+                        ++blkElemCnt_[colBlk_[i]];
+                    }
+                    else {
+                        elemCode_.push_back(cell * 4 + KindTriLo);
+                        elemCode_.push_back(cell * 4 + KindTriHi);
+                        triCnt_ += 2;
+                        blkElemCnt_[colBlk_[i]] += 2;
+                    } }
+
+    // The element of cell c that has the given side
+    PWP_UINT32  sideElem(const PWP_UINT32 c, const CellSide side) const {
+                    const PWP_UINT32 i = c % cellsX();
+                    const PWP_UINT32 j = c / cellsX();
+                    if (isQuadCell(i, j) || SideBottom == side ||
+                            SideRight == side) {
+                        return cellElem_[c];
+                    }
+                    // KindTriHi is numbered after KindTriLo
+                    return cellElem_[c] + 1; }
+
+    void        setFace(PWGM_FACESTREAM_DATA &fd, const PWP_UINT32 own,
+                    const CellSide ownSide, const PWP_UINT32 nbr,
+                    const CellSide nbrSide, const PWP_UINT32 dom) const {
+                    const PWP_UINT32 ownBlk = colBlk_[own % cellsX()];
+                    fd.owner.block.id = ownBlk;
+                    fd.owner.cellIndex = sideElem(own, ownSide);
+                    fd.owner.cellFace = PWP_UINT32(ownSide);
+                    fd.owner.domain.id = dom;
+                    if (PWP_UINT32_UNDEF == nbr) {
+                        fd.neighborCellIndex = PWP_UINT32_UNDEF;
+                        fd.type = PWGM_FACETYPE_BOUNDARY;
+                    }
+                    else {
+                        // the diagonal neighbor is the KindTriLo element
+                        fd.neighborCellIndex = (SideDiag == nbrSide) ?
+                            cellElem_[nbr] : sideElem(nbr, nbrSide);
+                        if (SideDiag == ownSide) {
+                            fd.owner.cellIndex = cellElem_[own] + 1;
+                        }
+                        fd.type = (colBlk_[nbr % cellsX()] == ownBlk) ?
+                            PWGM_FACETYPE_INTERIOR : PWGM_FACETYPE_CONNECTION;
+                    } }
+
+    static void setElem(PWGM_ELEMDATA &d, const PWGM_ENUM_ELEMTYPE type,
+                    const PWP_UINT32 v0, const PWP_UINT32 v1,
+                    const PWP_UINT32 v2, const PWP_UINT32 v3) {
+                    d.type = type;
+                    d.vertCnt = (PWGM_ELEMTYPE_QUAD == type) ? 4 : 3;
+                    d.index[0] = v0;
+                    d.index[1] = v1;
+                    d.index[2] = v2;
+                    d.index[3] = v3; }
+
+    static void setCondition(PWGM_CONDDATA &cd, const char *type,
+                    const PWP_UINT32 matId, const PWP_UINT32 zoneId,
+                    const bool isSet) {
+                    cd.name = type;
+                    cd.type = type;
+                    cd.id = zoneId;
+                    cd.tid = isSet ? (matId + 1) : 0; }
+
+    // A repeatable pseudo-random value in [0, 1) for vertex ndx
+    // x is (1e15 * i + 5) * 1e-21, within an ulp of a "%21.14E" rounding tie
+    // (1.000000000000005E-06 for i 1). The y of a boundary vertex is
+    // -j * 15/128. Its odd multiples are exact "%13.5E" ties (-0.1171875 for
+    // j 1). The y of an interior vertex is -(1e6 * j + 5) * 1e-7, within an
+    // ulp of a "%13.5E" tie (-0.1000005 for j 1).
+    void        tieVertex(const PWP_UINT32 i, const PWP_UINT32 j, PWP_REAL &x,
+                    PWP_REAL &y) const {
+                    x = (1e15 * i + 5.0) * 1e-21;
+                    if (i > 0 && j > 0 && i < cfg_.nx - 1 && j < cfg_.ny - 1) {
+                        y = -(1e6 * j + 5.0) * 1e-7;
+                    }
+                    else {
+                        y = -(j * 15.0 / 128.0);
+                    } }
+
+    static double jitter(const PWP_UINT32 ndx, const PWP_UINT32 salt) {
+                    PWP_UINT64 h = (PWP_UINT64(ndx) << 8) ^ salt;
+                    h ^= h >> 33;
+                    h *= 0xff51afd7ed558ccdULL;
+                    h ^= h >> 33;
+                    h *= 0xc4ceb9fe1a85ec53ULL;
+                    h ^= h >> 33;
+                    return double(h >> 11) / 9007199254740992.0; }
+
+private:
+
+    MockGridConfig          cfg_;
+
+    // The block of each cell column
+    std::vector<PWP_UINT32> colBlk_;
+
+    // The first cell column of each block (blockCnt + 1 entries)
+    std::vector<PWP_UINT32> blkFirstCol_;
+
+    // The element count of each block
+    std::vector<PWP_UINT32> blkElemCnt_;
+
+    // The first element of each cell
+    std::vector<PWP_UINT32> cellElem_;
+
+    // The cell * 4 + ElemKind of each element
+    std::vector<PWP_UINT32> elemCode_;
+
+    // The tri cells in row by row order
+    std::vector<PWP_UINT32> triCells_;
+
+    PWP_UINT32              triCnt_;
+    PWP_UINT32              quadCnt_;
+
+    // The solver attribute values
+    std::map<std::string, std::string>  attrs_;
+};
+
+#endif // _MOCKGRID_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,273 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK CaePlugin.h
+ *
+ * class PwpFile
+ * class CaeFaceStreamHandler
+ * class CaePlugin
+ *
+ * CaePlugin records every progress step instead of reporting it to a host.
+ * Messages are printed to stderr.
+ *
+ ***************************************************************************/
+
+#ifndef _CAEPLUGIN_H_
+#define _CAEPLUGIN_H_
+
+#include "apiCAEP.h"
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include<chrono>
+#include<cstdarg>
+#include<cstdio>
+#include<cstring>
+#include<string>
+#include<vector>
+
+
+// PwpFile open() mode bits
+enum {
+    pwpRead     = 0x01,
+    pwpWrite    = 0x02,
+    pwpAppend   = 0x04,
+    pwpBinary   = 0x08,
+    pwpAscii    = 0x10
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// A stdio FILE wrapper with the PluginSDK PwpFile interface
+class PwpFile {
+public:
+    PwpFile() :
+        fp_(0),
+        bytes_(0)
+    {
+    }
+
+    ~PwpFile()
+    {
+        close();
+    }
+
+    bool    open(const std::string &fileName, const int mode) {
+                close();
+                bytes_ = 0;
+                fp_ = fopen(fileName.c_str(), (0 != (mode & pwpAppend)) ?
+                    "ab" : ((0 != (mode & pwpWrite)) ? "wb" : "rb"));
+                return 0 != fp_; }
+
+    bool    close() {
+                bool ret = true;
+                if (0 != fp_) {
+                    ret = (0 == fclose(fp_));
+                    fp_ = 0;
+                }
+                return ret; }
+
+    bool    isOpen() const {
+                return 0 != fp_; }
+
+    size_t  write(const void *buf, const size_t size, const size_t cnt) {
+                const size_t ret = (0 == fp_) ? 0 : fwrite(buf, size, cnt, fp_);
+                bytes_ += PWP_UINT64(ret) * size;
+                return ret; }
+
+    bool    write(const char *str) {
+                const bool ret = (0 != fp_) && (EOF != fputs(str, fp_));
+                bytes_ += ret ? strlen(str) : 0;
+                return ret; }
+
+    bool    writef(const char *fmt, ...) {
+                if (0 == fp_) {
+                    return false;
+                }
+                va_list args;
+                va_start(args, fmt);
+                const int len = vfprintf(fp_, fmt, args);
+                va_end(args);
+                bytes_ += (len > 0) ? PWP_UINT64(len) : 0;
+                return len >= 0; }
+
+    // The bytes written since open()
+    PWP_UINT64  bytesWritten() const {
+                return bytes_; }
+
+private:
+
+    FILE *      fp_;
+    PWP_UINT64  bytes_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Receives the faces streamed by CaeUnsGridModel::streamFaces()
+class CaeFaceStreamHandler {
+public:
+    virtual ~CaeFaceStreamHandler()
+    {
+    }
+
+    virtual PWP_UINT32 streamBegin(const PWGM_BEGINSTREAM_DATA &) {
+                            return 1; }
+
+    virtual PWP_UINT32 streamFace(const PWGM_FACESTREAM_DATA &) = 0;
+
+    virtual PWP_UINT32 streamEnd(const PWGM_ENDSTREAM_DATA &) {
+                            return 1; }
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The record of one progress step
+struct CaeProgressStep {
+    PWP_UINT32  total;      // the progressBeginStep() total
+    PWP_UINT32  incrCnt;    // progressIncrement() calls
+    double      seconds;    // wall time from begin to end
+};
+
+typedef std::vector<CaeProgressStep>    CaeProgressStepArray1;
+
+
+class CaePlugin {
+public:
+    CaePlugin(CAEP_RTITEM *pRti, const CAEP_WRITEINFO *pWriteInfo) :
+        rti_(*pRti),
+        writeInfo_(*pWriteInfo),
+        rtFile_(),
+        majorSteps_(0),
+        steps_(),
+        stepStart_(),
+        errorCnt_(0),
+        abortAfter_(0),
+        incrTotal_(0)
+    {
+    }
+
+    virtual ~CaePlugin()
+    {
+    }
+
+    // Fails every progressIncrement() after cnt increments (0 never fails)
+    void    setAbortAfter(const PWP_UINT32 cnt) {
+                abortAfter_ = cnt; }
+
+    PWP_UINT32  majorSteps() const {
+                return majorSteps_; }
+
+    const CaeProgressStepArray1 & progressSteps() const {
+                return steps_; }
+
+    PWP_UINT32  errorCount() const {
+                return errorCnt_; }
+
+protected:
+
+    void    setProgressMajorSteps(const PWP_UINT32 steps) {
+                majorSteps_ = steps; }
+
+    bool    progressBeginStep(const PWP_UINT32 total) {
+                CaeProgressStep step = { total, 0, 0.0 };
+                steps_.push_back(step);
+                stepStart_ = Clock::now();
+                return !isAborted(); }
+
+    bool    progressIncrement() {
+                if (!steps_.empty()) {
+                    ++steps_.back().incrCnt;
+                }
+                ++incrTotal_;
+                return !isAborted(); }
+
+    bool    progressEndStep() {
+                if (!steps_.empty()) {
+                    steps_.back().seconds = std::chrono::duration<double>(
+                        Clock::now() - stepStart_).count();
+                }
+                return !isAborted(); }
+
+    void    sendErrorMsg(const char *msg, const PWP_UINT32 id = 0) const {
+                ++errorCnt_;
+                fprintf(stderr, "error: %s (%lu)\n", msg, (unsigned long)id); }
+
+    void    sendWarningMsg(const char *msg, const PWP_UINT32 id = 0) const {
+                fprintf(stderr, "warning: %s (%lu)\n", msg,
+                    (unsigned long)id); }
+
+    void    sendInfoMsg(const char *msg, const PWP_UINT32 id = 0) const {
+                fprintf(stderr, "info: %s (%lu)\n", msg, (unsigned long)id); }
+
+    // The published values are not needed. CaeUnsGridModel::getAttribute()
+    // returns the caller's default for unset attributes.
+    static bool publishBoolValueDef(CAEP_RTITEM &, const char *, const bool,
+                    const char *) {
+                return true; }
+
+    static bool publishUIntValueDef(CAEP_RTITEM &, const char *,
+                    const PWP_UINT, const char *, const PWP_UINT,
+                    const PWP_UINT) {
+                return true; }
+
+    static bool publishEnumValueDef(CAEP_RTITEM &, const char *,
+                    const char *, const char *, const char *) {
+                return true; }
+
+    static bool publishStringValueDef(CAEP_RTITEM &, const char *,
+                    const char *, const char *) {
+                return true; }
+
+private:
+
+    typedef std::chrono::steady_clock   Clock;
+
+    bool    isAborted() const {
+                return (0 != abortAfter_) && (incrTotal_ >= abortAfter_); }
+
+protected:
+
+    CAEP_RTITEM &           rti_;
+    CAEP_WRITEINFO          writeInfo_;
+    PwpFile                 rtFile_;
+
+private:
+
+    PWP_UINT32              majorSteps_;
+    CaeProgressStepArray1   steps_;
+    Clock::time_point       stepStart_;
+    mutable PWP_UINT32      errorCnt_;
+    PWP_UINT32              abortAfter_;
+    PWP_UINT32              incrTotal_;
+};
+
+#endif // _CAEPLUGIN_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,313 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK CaeUnsGridModel.h and CaeUnsPlugin.h
+ *
+ * class CaeUnsGridModel
+ * class CaeUnsBlock
+ * class CaeUnsPatch
+ * class CaeUnsVertex
+ * class CaeUnsElement
+ * class CaeUnsPlugin
+ *
+ * and the PwModEnumElements() and PwElemDataModEnum() functions declared in
+ * apiGridModel.h.
+ *
+ * Every call is forwarded to the MockGrid of the PWGM_HGRIDMODEL handle.
+ *
+ ***************************************************************************/
+
+#ifndef _CAEUNSGRIDMODEL_H_
+#define _CAEUNSGRIDMODEL_H_
+
+#include "apiCAEP.h"
+#include "apiGridModel.h"
+#include "apiPWP.h"
+#include "CaePlugin.h"
+
+#include "MockGrid.h"
+
+#include<cstdlib>
+#include<cstring>
+#include<string>
+
+
+inline PWGM_HELEMENT
+PwModEnumElements(PWGM_HGRIDMODEL model, PWP_UINT32 ndx)
+{
+    PWGM_HELEMENT ret = { model, PWP_UINT32_UNDEF, ndx };
+    return ret;
+}
+
+
+inline PWP_BOOL
+PwElemDataModEnum(PWGM_HELEMENT element, PWGM_ENUMELEMDATA *pEnumElemData)
+{
+    const bool ret = (0 != element.model) && (0 != pEnumElemData) &&
+        (element.id < element.model->elementCount());
+    if (ret) {
+        element.model->element(element.id, pEnumElemData->elemData);
+        pEnumElemData->hBlkElement = element;
+        pEnumElemData->hBlkElement.pid = element.model->elementBlock(
+            element.id);
+    }
+    return ret ? PWP_TRUE : PWP_FALSE;
+}
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+class CaeUnsGridModel {
+public:
+    explicit CaeUnsGridModel(PWGM_HGRIDMODEL model) :
+        model_(model)
+    {
+    }
+
+    PWGM_HGRIDMODEL model() const {
+                    return model_; }
+
+    PWP_UINT32  vertexCount() const {
+                    return model_->vertexCount(); }
+
+    PWP_UINT32  elementCount(PWGM_ELEMCOUNTS *pCounts = 0) const {
+                    if (0 != pCounts) {
+                        memset(pCounts, 0, sizeof(*pCounts));
+                        PWGM_ECNT_Tri(*pCounts) = model_->triCount();
+                        PWGM_ECNT_Quad(*pCounts) = model_->quadCount();
+                    }
+                    return model_->elementCount(); }
+
+    PWP_UINT32  blockCount() const {
+                    return model_->blockCount(); }
+
+    PWP_UINT32  patchCount() const {
+                    return model_->domainCount(); }
+
+    bool        getAttribute(const char *name, const char *&val,
+                    const char *defVal) const {
+                    const char *str = model_->findAttribute(name);
+                    val = (0 == str) ? defVal : str;
+                    return 0 != str; }
+
+    bool        getAttribute(const char *name, PWP_UINT &val,
+                    const PWP_UINT defVal) const {
+                    const char *str = model_->findAttribute(name);
+                    char *end = 0;
+                    const unsigned long v = (0 == str) ? 0 :
+                        strtoul(str, &end, 10);
+                    const bool ret = (0 != str) && (end != str) &&
+                        ('\0' == *end);
+                    val = ret ? PWP_UINT(v) : defVal;
+                    return ret; }
+
+    bool        getAttribute(const char *name, bool &val,
+                    const bool defVal) const {
+                    const char *str = model_->findAttribute(name);
+                    const bool isTrue = (0 != str) && (0 == strcmp(str, "1") ||
+                        0 == strcmp(str, "true"));
+                    const bool ret = isTrue || ((0 != str) &&
+                        (0 == strcmp(str, "0") || 0 == strcmp(str, "false")));
+                    val = ret ? isTrue : defVal;
+                    return ret; }
+
+    bool        streamFaces(const PWGM_ENUM_FACEORDER /*order*/,
+                    CaeFaceStreamHandler &handler) const {
+                    return model_->streamFaces(handler); }
+
+private:
+
+    PWGM_HGRIDMODEL model_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// Iterates the first to last item of a CaeUnsGridModel
+class CaeUnsIterator {
+public:
+    PWP_UINT32  index() const {
+                    return ndx_; }
+
+    bool        isValid() const {
+                    return ndx_ < cnt_; }
+
+protected:
+
+    CaeUnsIterator(const CaeUnsGridModel &model, const PWP_UINT32 cnt) :
+        grid_(*model.model()),
+        ndx_(0),
+        cnt_(cnt)
+    {
+    }
+
+protected:
+
+    const MockGrid &    grid_;
+    PWP_UINT32          ndx_;
+    PWP_UINT32          cnt_;
+};
+
+
+class CaeUnsBlock : public CaeUnsIterator {
+public:
+    explicit CaeUnsBlock(const CaeUnsGridModel &model) :
+        CaeUnsIterator(model, model.blockCount())
+    {
+    }
+
+    CaeUnsBlock & operator++() {
+                    ++ndx_;
+                    return *this; }
+
+    PWP_UINT32  elementCount() const {
+                    return grid_.blockElementCount(ndx_); }
+
+    bool        condition(PWGM_CONDDATA &cd) const {
+                    return grid_.blockCondition(ndx_, cd); }
+};
+
+
+class CaeUnsPatch : public CaeUnsIterator {
+public:
+    explicit CaeUnsPatch(const CaeUnsGridModel &model) :
+        CaeUnsIterator(model, model.patchCount())
+    {
+    }
+
+    CaeUnsPatch & operator++() {
+                    ++ndx_;
+                    return *this; }
+
+    bool        condition(PWGM_CONDDATA &cd) const {
+                    return grid_.domainCondition(ndx_, cd); }
+};
+
+
+class CaeUnsVertex : public CaeUnsIterator {
+public:
+    explicit CaeUnsVertex(const CaeUnsGridModel &model) :
+        CaeUnsIterator(model, model.vertexCount()),
+        x_(0.0),
+        y_(0.0),
+        z_(0.0)
+    {
+        load();
+    }
+
+    CaeUnsVertex & operator++() {
+                    ++ndx_;
+                    load();
+                    return *this; }
+
+    PWP_REAL    x() const {
+                    return x_; }
+
+    PWP_REAL    y() const {
+                    return y_; }
+
+    PWP_REAL    z() const {
+                    return z_; }
+
+private:
+
+    void        load() {
+                    if (isValid()) {
+                        grid_.vertex(ndx_, x_, y_, z_);
+                    } }
+
+private:
+
+    PWP_REAL    x_;
+    PWP_REAL    y_;
+    PWP_REAL    z_;
+};
+
+
+class CaeUnsElement : public CaeUnsIterator {
+public:
+    explicit CaeUnsElement(const CaeUnsGridModel &model) :
+        CaeUnsIterator(model, model.elementCount())
+    {
+    }
+
+    CaeUnsElement & operator++() {
+                    ++ndx_;
+                    return *this; }
+
+    bool        data(PWGM_ELEMDATA &d) const {
+                    const bool ret = isValid();
+                    if (ret) {
+                        grid_.element(ndx_, d);
+                    }
+                    return ret; }
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+class CaeUnsPlugin : public CaePlugin {
+public:
+    CaeUnsPlugin(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
+            const CAEP_WRITEINFO *pWriteInfo) :
+        CaePlugin(pRti, pWriteInfo),
+        model_(model)
+    {
+    }
+
+    virtual ~CaeUnsPlugin()
+    {
+    }
+
+    // Runs one export to writeInfo_.fileDest the way the PluginSDK does.
+    // endExport() is called even if beginExport() or write() fails.
+    bool    run() {
+                bool ret = rtFile_.open(writeInfo_.fileDest,
+                    (PWP_ENCODING_ASCII == writeInfo_.encoding) ?
+                        (pwpWrite | pwpAscii) : (pwpWrite | pwpBinary));
+                if (!ret) {
+                    sendErrorMsg("Could not open the export file");
+                    return false;
+                }
+                ret = beginExport() && write();
+                ret = endExport() && ret;
+                return rtFile_.close() && ret; }
+
+protected:
+
+    virtual bool beginExport() = 0;
+    virtual PWP_BOOL write() = 0;
+    virtual bool endExport() = 0;
+
+protected:
+
+    CaeUnsGridModel model_;
+};
+
+#endif // _CAEUNSGRIDMODEL_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,72 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK apiCAEP.h
+ *
+ * Only the types used by CaeUnsUMCPSEG are declared.
+ *
+ ***************************************************************************/
+
+#ifndef _APICAEP_H_
+#define _APICAEP_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include<ctime>
+
+
+#define CAEPU_CLKS_SIZE 8
+
+struct CAEP_BCINFO {
+    const char *    phystype;
+    PWP_INT32       id;
+};
+
+struct CAEP_VCINFO {
+    const char *    phystype;
+    PWP_INT32       id;
+};
+
+struct CAEP_WRITEINFO {
+    const char *        fileDest;
+    PWP_BOOL            conditionsOnly;
+    PWP_ENUM_ENCODING   encoding;
+    PWP_ENUM_PRECISION  precision;
+    PWP_ENUM_DIMENSION  dimension;
+};
+
+struct CAEP_RTITEM {
+    CAEP_BCINFO *       pBCInfo;
+    PWP_UINT32          BCCnt;
+    CAEP_VCINFO *       pVCInfo;
+    PWP_UINT32          VCCnt;
+    PWGM_HGRIDMODEL     model;
+    const CAEP_WRITEINFO *pWriteInfo;
+    PWP_UINT32          progTotal;
+    PWP_UINT32          progComplete;
+    clock_t             clocks[CAEPU_CLKS_SIZE];
+    PWP_BOOL            opAborted;
+};
+
+#endif // _APICAEP_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,44 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK apiCAEPUtils.h
+ *
+ ***************************************************************************/
+
+#ifndef _APICAEPUTILS_H_
+#define _APICAEPUTILS_H_
+
+#include "apiCAEP.h"
+
+
+// Info values are not used by the harness
+inline bool
+caeuAssignInfoValue(const char *key, const char *value, bool createOnly)
+{
+    (void)key;
+    (void)value;
+    (void)createOnly;
+    return true;
+}
+
+#endif // _APICAEPUTILS_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,158 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK apiGridModel.h
+ *
+ * A grid model handle is a pointer to a MockGrid (see MockGrid.h). Only the
+ * types used by CaeUnsUMCPSEG are declared.
+ *
+ ***************************************************************************/
+
+#ifndef _APIGRIDMODEL_H_
+#define _APIGRIDMODEL_H_
+
+#include "apiPWP.h"
+
+
+class MockGrid;
+
+typedef const MockGrid *    PWGM_HGRIDMODEL;
+
+struct PWGM_HBLOCK {
+    PWGM_HGRIDMODEL model;
+    PWP_UINT32      id;
+};
+
+struct PWGM_HDOMAIN {
+    PWGM_HGRIDMODEL model;
+    PWP_UINT32      id;     // PWP_UINT32_UNDEF if not valid
+};
+
+#define PWGM_HBLOCK_ID(h)           ((h).id)
+#define PWGM_HDOMAIN_ID(h)          ((h).id)
+#define PWGM_HDOMAIN_ISVALID(h)     (PWP_UINT32_UNDEF != (h).id)
+
+
+enum PWGM_ENUM_ELEMTYPE {
+    PWGM_ELEMTYPE_BAR,
+    PWGM_ELEMTYPE_HEX,
+    PWGM_ELEMTYPE_QUAD,
+    PWGM_ELEMTYPE_TRI,
+    PWGM_ELEMTYPE_TET,
+    PWGM_ELEMTYPE_WEDGE,
+    PWGM_ELEMTYPE_PYRAMID,
+    PWGM_ELEMTYPE_POINT,
+    PWGM_ELEMTYPE_SIZE
+};
+
+#define PWGM_ELEMDATA_VERT_SIZE 8
+
+struct PWGM_ELEMDATA {
+    PWGM_ENUM_ELEMTYPE  type;
+    PWP_UINT32          vertCnt;
+    PWP_UINT32          index[PWGM_ELEMDATA_VERT_SIZE];
+};
+
+struct PWGM_ELEMCOUNTS {
+    PWP_UINT32  count[PWGM_ELEMTYPE_SIZE];
+};
+
+#define PWGM_ECNT_Quad(ecs)     ((ecs).count[PWGM_ELEMTYPE_QUAD])
+#define PWGM_ECNT_Tri(ecs)      ((ecs).count[PWGM_ELEMTYPE_TRI])
+
+
+struct PWGM_CONDDATA {
+    const char *    name;
+    PWP_UINT32      id;     // user id
+    const char *    type;
+    PWP_UINT32      tid;    // type id (0 if not set)
+};
+
+
+enum PWGM_ENUM_FACETYPE {
+    PWGM_FACETYPE_BOUNDARY,
+    PWGM_FACETYPE_INTERIOR,
+    PWGM_FACETYPE_CONNECTION
+};
+
+enum PWGM_ENUM_FACEORDER {
+    PWGM_FACEORDER_DONTCARE,
+    PWGM_FACEORDER_BOUNDARYFIRST,
+    PWGM_FACEORDER_INTERIORFIRST
+};
+
+struct PWGM_BEGINSTREAM_DATA {
+    PWGM_HGRIDMODEL     model;
+    PWP_UINT32          totalNumFaces;
+    PWP_UINT32          numBoundaryFaces;
+    PWP_UINT32          numConnections;
+    PWP_UINT32          numInteriorFaces;
+    void *              userData;
+};
+
+struct PWGM_FACEREF {
+    PWGM_HBLOCK         block;
+    PWP_UINT32          cellIndex;
+    PWP_UINT32          cellFace;
+    PWGM_HDOMAIN        domain;
+};
+
+struct PWGM_FACESTREAM_DATA {
+    PWGM_HGRIDMODEL     model;
+    PWP_UINT32          face;
+    PWGM_ELEMDATA       elemData;
+    PWGM_FACEREF        owner;
+    PWP_UINT32          neighborCellIndex;
+    PWGM_ENUM_FACETYPE  type;
+    void *              userData;
+};
+
+struct PWGM_ENDSTREAM_DATA {
+    PWGM_HGRIDMODEL     model;
+    PWP_BOOL            ok;
+    void *              userData;
+};
+
+
+// An element of the model (pid is PWP_UINT32_UNDEF) or of a block (pid is
+// the block index). id is the model element index in both cases.
+struct PWGM_HELEMENT {
+    PWGM_HGRIDMODEL model;
+    PWP_UINT32      pid;
+    PWP_UINT32      id;
+};
+
+#define PWGM_HELEMENT_PID(h)        ((h).pid)
+
+struct PWGM_ENUMELEMDATA {
+    PWGM_ELEMDATA   elemData;
+    PWGM_HELEMENT   hBlkElement;
+};
+
+// Defined in CaeUnsGridModel.h
+inline PWGM_HELEMENT PwModEnumElements(PWGM_HGRIDMODEL model,
+    PWP_UINT32 ndx);
+inline PWP_BOOL PwElemDataModEnum(PWGM_HELEMENT element,
+    PWGM_ENUMELEMDATA *pEnumElemData);
+
+#endif // _APIGRIDMODEL_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
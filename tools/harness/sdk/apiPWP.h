@@ -0,0 +1,74 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * Harness stand-in for the PluginSDK apiPWP.h
+ *
+ * Only the types and values used by CaeUnsUMCPSEG are declared. See
+ * tools/harness/README.md.
+ *
+ ***************************************************************************/
+
+#ifndef _APIPWP_H_
+#define _APIPWP_H_
+
+#include<cstddef>
+#include<stdint.h>
+
+
+typedef uint64_t        PWP_UINT64;
+typedef int64_t         PWP_INT64;
+typedef uint32_t        PWP_UINT32;
+typedef int32_t         PWP_INT32;
+typedef uint8_t         PWP_UINT8;
+typedef int8_t          PWP_INT8;
+typedef unsigned int    PWP_UINT;
+typedef int             PWP_INT;
+typedef double          PWP_REAL;
+typedef int             PWP_BOOL;
+
+#define PWP_FALSE           0
+#define PWP_TRUE            1
+#define PWP_UINT32_UNDEF    (~PWP_UINT32(0))
+
+#define PWP_SITE_GROUPNAME  "Harness"
+
+#define ARRAYSIZE(arr)      (sizeof(arr) / sizeof(arr[0]))
+
+
+enum PWP_ENUM_ENCODING {
+    PWP_ENCODING_ASCII,
+    PWP_ENCODING_BINARY,
+    PWP_ENCODING_UNFORMATTED
+};
+
+enum PWP_ENUM_PRECISION {
+    PWP_PRECISION_SINGLE,
+    PWP_PRECISION_DOUBLE
+};
+
+enum PWP_ENUM_DIMENSION {
+    PWP_DIMENSION_2D,
+    PWP_DIMENSION_3D
+};
+
+#endif // _APIPWP_H_
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
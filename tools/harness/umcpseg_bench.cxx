@@ -0,0 +1,450 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * umcpseg_bench
+ *
+ * Google Benchmark suite of the CaeUnsUMCPSEG export phases on MockGrid
+ * grids. Each phase benchmark builds the plugin state the phase needs with
+ * the timer paused, then times the phase alone:
+ *
+ *   Stream      streamEdges()      stream and classify the edges
+ *   NodeTable   buildNodeTables()  fill nodeInfo_ and nodeNbors_
+ *   SortIndex   sortNbors()        NeighborOrder Index, faces shuffled
+ *   SortAngle   sortNbors()        NeighborOrder Angle, faces shuffled
+ *   Nodes       writeNodes()     (ASCII, to /dev/null)
+ *   Faces       writeFaces()     (ASCII, to /dev/null)
+ *   Geometry    writeGeometry()  (ASCII, to /dev/null)
+ *   Export      a complete ASCII or binary export to a temporary file
+ *
+ * The benchmark arguments are the grid vertex count and the ThreadCount
+ * solver attribute (0 is one thread per core). The counters are:
+ *
+ *   nodes/s         grid vertices per second
+ *   bytes_per_second  output bytes per second
+ *   heap/node       operator new calls per vertex (includes arena blocks)
+ *   arena/node      MonotonicArena allocations per vertex
+ *
+ *   make bench
+ *   ./umcpseg_bench --benchmark_filter=Nodes
+ *
+ ***************************************************************************/
+
+// gcc flags the free() of the replaced operator delete below as mismatched
+// with operator new once both are inlined
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#   pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+#include "CaeUnsUMCPSEG.h"
+#include "MockGrid.h"
+
+#include<benchmark/benchmark.h>
+
+#include<atomic>
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<map>
+#include<new>
+#include<string>
+
+
+// Counts every operator new call of the process
+static std::atomic<PWP_UINT64> HeapAllocs(0);
+
+
+void *
+operator new(size_t bytes)
+{
+    ++HeapAllocs;
+    void *p = malloc((0 == bytes) ? 1 : bytes);
+    if (0 == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *
+operator new[](size_t bytes)
+{
+    return operator new(bytes);
+}
+
+void
+operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void
+operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+
+// The export phases
+enum BenchPhase {
+    PhaseStream,
+    PhaseNodeTable,
+    PhaseSortIndex,
+    PhaseSortAngle,
+    PhaseNodes,
+    PhaseFaces,
+    PhaseGeometry
+};
+
+
+// Returns the grid with about nodeCnt vertices that streams its faces row by
+// row or shuffled. The grids are built once.
+static MockGrid &
+benchGrid(const PWP_UINT32 nodeCnt, const bool shuffleFaces = false)
+{
+    typedef std::pair<PWP_UINT32, bool> GridKey;
+    static std::map<GridKey, MockGrid> grids;
+    const GridKey key(nodeCnt, shuffleFaces);
+    std::map<GridKey, MockGrid>::iterator it = grids.find(key);
+    if (grids.end() == it) {
+        MockGridConfig cfg;
+        cfg.nx = PWP_UINT32(std::sqrt(double(nodeCnt)) + 0.5);
+        cfg.ny = (nodeCnt + cfg.nx - 1) / cfg.nx;
+        cfg.mix = MockElemMixed;
+        cfg.blockCnt = 4;
+        cfg.materialCnt = 3;
+        cfg.shuffleFaces = shuffleFaces;
+        it = grids.insert(std::make_pair(key, MockGrid())).first;
+        it->second.create(cfg);
+    }
+    return it->second;
+}
+
+
+static void
+setThreadCount(MockGrid &grid, const PWP_UINT32 numThreads)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "ThreadCount=%lu", (unsigned long)numThreads);
+    grid.setAttribute(buf);
+}
+
+
+// The sort phases select their NeighborOrder. The others use the default.
+static void
+setNborOrder(MockGrid &grid, const BenchPhase phase)
+{
+    switch (phase) {
+    case PhaseSortIndex: grid.setAttribute("NeighborOrder=Index"); break;
+    case PhaseSortAngle: grid.setAttribute("NeighborOrder=Angle"); break;
+    default:             grid.setAttribute("NeighborOrder=Stream"); break;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+// The plugin with its export phases and output file made public
+class BenchPlugin : public CaeUnsUMCPSEG {
+public:
+    BenchPlugin(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
+            const CAEP_WRITEINFO *pWriteInfo) :
+        CaeUnsUMCPSEG(pRti, model, pWriteInfo)
+    {
+    }
+
+    using CaeUnsUMCPSEG::beginExport;
+    using CaeUnsUMCPSEG::write;
+    using CaeUnsUMCPSEG::endExport;
+    using CaeUnsUMCPSEG::init;
+    using CaeUnsUMCPSEG::streamEdges;
+    using CaeUnsUMCPSEG::buildNodeTables;
+    using CaeUnsUMCPSEG::loadVertices;
+    using CaeUnsUMCPSEG::sortNbors;
+    using CaeUnsUMCPSEG::loadElements;
+    using CaeUnsUMCPSEG::writeNodes;
+    using CaeUnsUMCPSEG::writeFaces;
+    using CaeUnsUMCPSEG::writeGeometry;
+    using CaeUnsUMCPSEG::flushOutput;
+    using CaeUnsUMCPSEG::arena;
+
+    bool        open() {
+                    return rtFile_.open(writeInfo_.fileDest, pwpWrite); }
+
+    bool        close() {
+                    return rtFile_.close(); }
+
+    PWP_UINT64  bytesWritten() const {
+                    return rtFile_.bytesWritten(); }
+};
+
+
+// Drives the phases of one CaeUnsUMCPSEG export. The output goes to
+// /dev/null.
+class UmcpsegBench {
+public:
+    explicit UmcpsegBench(const MockGrid &grid) :
+        writeInfo_(),
+        rti_(),
+        plugin_(0),
+        isOk_(false)
+    {
+        memset(&writeInfo_, 0, sizeof(writeInfo_));
+        writeInfo_.fileDest = "/dev/null";
+        writeInfo_.encoding = PWP_ENCODING_ASCII;
+        writeInfo_.precision = PWP_PRECISION_DOUBLE;
+        writeInfo_.dimension = PWP_DIMENSION_2D;
+        memset(&rti_, 0, sizeof(rti_));
+        rti_.model = &grid;
+        rti_.pWriteInfo = &writeInfo_;
+        plugin_ = new BenchPlugin(&rti_, &grid, &writeInfo_);
+        isOk_ = plugin_->open() && plugin_->beginExport();
+    }
+
+    ~UmcpsegBench()
+    {
+        plugin_->endExport();
+        plugin_->close();
+        delete plugin_;
+    }
+
+    bool        isOk() const {
+                    return isOk_; }
+
+    // Builds the plugin state needed by phase
+    bool        prepare(const BenchPhase phase) {
+                    bool ret = isOk_;
+                    switch (phase) {
+                    case PhaseStream:
+                        break;
+                    case PhaseNodeTable:
+                        ret = ret && plugin_->streamEdges();
+                        break;
+                    case PhaseSortIndex:
+                    case PhaseSortAngle:
+                        ret = ret && plugin_->init() &&
+                            plugin_->loadVertices();
+                        break;
+                    default:
+                        ret = ret && plugin_->init() &&
+                            plugin_->loadVertices() && plugin_->sortNbors() &&
+                            (PhaseFaces != phase || plugin_->loadElements());
+                        break;
+                    }
+                    return ret; }
+
+    // Runs phase. Any buffered output is flushed.
+    bool        run(const BenchPhase phase) {
+                    bool ret = false;
+                    switch (phase) {
+                    case PhaseStream:
+                        ret = plugin_->streamEdges();
+                        break;
+                    case PhaseNodeTable:
+                        plugin_->buildNodeTables();
+                        ret = true;
+                        break;
+                    case PhaseSortIndex:
+                    case PhaseSortAngle:
+                        ret = plugin_->sortNbors();
+                        break;
+                    case PhaseNodes:
+                        ret = plugin_->writeNodes();
+                        break;
+                    case PhaseFaces:
+                        ret = plugin_->writeFaces();
+                        break;
+                    case PhaseGeometry:
+                        ret = plugin_->writeGeometry();
+                        break;
+                    }
+                    return plugin_->flushOutput() && ret; }
+
+    // Starts over with an empty export. endExport() drops whatever the
+    // phases left behind.
+    void        reset() {
+                    plugin_->endExport();
+                    isOk_ = isOk_ && plugin_->beginExport(); }
+
+    PWP_UINT64  bytesWritten() const {
+                    return plugin_->bytesWritten(); }
+
+    const MonotonicArena & arena() const {
+                    return plugin_->arena(); }
+
+    // Runs a complete export like CaeUnsPlugin::run(). arenaCnt is set to the
+    // arena allocations made before endExport() releases them.
+    static bool runExport(CAEP_RTITEM &rti, const CAEP_WRITEINFO &writeInfo,
+                    size_t &arenaCnt) {
+                    BenchPlugin plugin(&rti, rti.model, &writeInfo);
+                    bool ret = plugin.open() && plugin.beginExport() &&
+                        plugin.write();
+                    arenaCnt = plugin.arena().allocCount();
+                    ret = plugin.endExport() && ret;
+                    return plugin.close() && ret &&
+                        (0 == plugin.errorCount()); }
+
+private:
+
+    CAEP_WRITEINFO  writeInfo_;
+    CAEP_RTITEM     rti_;
+    BenchPlugin *   plugin_;
+    bool            isOk_;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+static void
+setCounters(benchmark::State &state, const PWP_UINT32 nodeCnt,
+    const PWP_UINT64 bytes, const PWP_UINT64 heapAllocs,
+    const PWP_UINT64 arenaAllocs)
+{
+    typedef benchmark::Counter Counter;
+    if (0 != bytes) {
+        state.SetBytesProcessed(int64_t(bytes));
+    }
+    state.counters["nodes/s"] = Counter(double(nodeCnt) *
+        double(state.iterations()), Counter::kIsRate);
+    state.counters["heap/node"] = Counter(double(heapAllocs) / nodeCnt,
+        Counter::kAvgIterations);
+    state.counters["arena/node"] = Counter(double(arenaAllocs) / nodeCnt,
+        Counter::kAvgIterations);
+}
+
+
+// The sort phases stream the faces shuffled so that the neighbors of each
+// node arrive unsorted, as they do from a real grid.
+static void
+benchPhase(benchmark::State &state, const BenchPhase phase)
+{
+    const bool isSort = (PhaseSortIndex == phase) ||
+        (PhaseSortAngle == phase);
+    MockGrid &grid = benchGrid(PWP_UINT32(state.range(0)), isSort);
+    setThreadCount(grid, PWP_UINT32(state.range(1)));
+    setNborOrder(grid, phase);
+    UmcpsegBench bench(grid);
+    const MonotonicArena &arena = bench.arena();
+    PWP_UINT64 bytes = 0;
+    PWP_UINT64 heapAllocs = 0;
+    PWP_UINT64 arenaAllocs = 0;
+    bool ok = bench.isOk();
+    for (auto _ : state) {
+        state.PauseTiming();
+        ok = ok && bench.prepare(phase);
+        const PWP_UINT64 bytes0 = bench.bytesWritten();
+        const PWP_UINT64 heap0 = HeapAllocs;
+        const PWP_UINT64 arena0 = arena.allocCount();
+        state.ResumeTiming();
+
+        ok = ok && bench.run(phase);
+
+        state.PauseTiming();
+        bytes += bench.bytesWritten() - bytes0;
+        heapAllocs += HeapAllocs - heap0;
+        arenaAllocs += arena.allocCount() - arena0;
+        bench.reset();
+        state.ResumeTiming();
+        if (!ok) {
+            state.SkipWithError("export phase failed");
+            break;
+        }
+    }
+    setCounters(state, grid.vertexCount(), bytes, heapAllocs, arenaAllocs);
+}
+
+
+static void
+benchExport(benchmark::State &state, const PWP_ENUM_ENCODING encoding)
+{
+    MockGrid &grid = benchGrid(PWP_UINT32(state.range(0)));
+    setThreadCount(grid, PWP_UINT32(state.range(1)));
+    const char *tmpDir = getenv("TMPDIR");
+    const std::string fileName = std::string((0 == tmpDir) ? "/tmp" :
+        tmpDir) + "/umcpseg_bench.nlist";
+
+    CAEP_WRITEINFO writeInfo;
+    memset(&writeInfo, 0, sizeof(writeInfo));
+    writeInfo.fileDest = fileName.c_str();
+    writeInfo.encoding = encoding;
+    writeInfo.precision = PWP_PRECISION_DOUBLE;
+    writeInfo.dimension = PWP_DIMENSION_2D;
+    CAEP_RTITEM rti;
+    memset(&rti, 0, sizeof(rti));
+    rti.model = &grid;
+    rti.pWriteInfo = &writeInfo;
+
+    PWP_UINT64 bytes = 0;
+    PWP_UINT64 heapAllocs = 0;
+    PWP_UINT64 arenaAllocs = 0;
+    for (auto _ : state) {
+        const PWP_UINT64 heap0 = HeapAllocs;
+        size_t arenaCnt = 0;
+        if (!UmcpsegBench::runExport(rti, writeInfo, arenaCnt)) {
+            state.SkipWithError("export failed");
+            break;
+        }
+        state.PauseTiming();
+        heapAllocs += HeapAllocs - heap0;
+        arenaAllocs += arenaCnt;
+        FILE *fp = fopen(fileName.c_str(), "rb");
+        if (0 != fp) {
+            if (0 == fseek(fp, 0, SEEK_END)) {
+                bytes += PWP_UINT64(ftell(fp));
+            }
+            fclose(fp);
+        }
+        state.ResumeTiming();
+    }
+    remove(fileName.c_str());
+    setCounters(state, grid.vertexCount(), bytes, heapAllocs, arenaAllocs);
+}
+
+
+// The grid sizes and thread counts of every benchmark
+static void
+benchArgs(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({ "nodes", "threads" });
+    for (PWP_UINT32 nodeCnt = 10000; nodeCnt <= 1000000; nodeCnt *= 10) {
+        b->Args({ nodeCnt, 1 });
+        b->Args({ nodeCnt, 0 });
+    }
+    b->Unit(benchmark::kMillisecond);
+    b->UseRealTime();
+}
+
+
+BENCHMARK_CAPTURE(benchPhase, Stream, PhaseStream)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, NodeTable, PhaseNodeTable)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, SortIndex, PhaseSortIndex)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, SortAngle, PhaseSortAngle)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, Nodes, PhaseNodes)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, Faces, PhaseFaces)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchPhase, Geometry, PhaseGeometry)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchExport, Ascii, PWP_ENCODING_ASCII)->Apply(benchArgs);
+BENCHMARK_CAPTURE(benchExport, Binary, PWP_ENCODING_BINARY)->Apply(benchArgs);
+
+BENCHMARK_MAIN();
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
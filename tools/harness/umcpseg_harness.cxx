@@ -0,0 +1,498 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * umcpseg_harness
+ *
+ * Runs CaeUnsUMCPSEG exports of a synthetic MockGrid without the host
+ * application. The plugin source is compiled unchanged against the SDK
+ * stand-ins in tools/harness/sdk. See tools/harness/README.md.
+ *
+ *   umcpseg_harness --nodes 1000000 --format binary --out grid.nlist
+ *
+ ***************************************************************************/
+
+#include "CaeUnsUMCPSEG.h"
+#include "MockGrid.h"
+#include "NlistBinary.h"
+
+#include<chrono>
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<string>
+#include<vector>
+
+
+struct HarnessOptions {
+    HarnessOptions() :
+        grid(),
+        encoding(PWP_ENCODING_ASCII),
+        outFile("harness.nlist"),
+        attrs(),
+        repeat(1),
+        abortAfter(0),
+        verify(false),
+        quiet(false)
+    {
+    }
+
+    MockGridConfig              grid;
+    PWP_ENUM_ENCODING           encoding;
+    std::string                 outFile;
+    std::vector<std::string>    attrs;      // name=value
+    PWP_UINT32                  repeat;
+    PWP_UINT32                  abortAfter; // see CaePlugin::setAbortAfter()
+    bool                        verify;
+    bool                        quiet;
+};
+
+
+static void
+usage(const char *exe)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --nx N              vertices in x (default 101)\n"
+        "  --ny N              vertices in y (default 101)\n"
+        "  --nodes N           about N vertices on a square lattice\n"
+        "  --elems tri|quad|mixed  cell types (default mixed)\n"
+        "  --elem-order blocks|rows  element numbering (default blocks)\n"
+        "  --coords jittered|ties  vertex coordinates (default jittered)\n"
+        "  --blocks N          blocks (vertical strips, default 4)\n"
+        "  --materials N       distinct VC materials, 0 for no VCs "
+            "(default 2)\n"
+        "  --no-bcs            the domains have no BCs\n"
+        "  --shuffle-faces     stream the faces in a scattered order\n"
+        "  --format ascii|binary  export file format (default ascii)\n"
+        "  --out FILE          export file (default harness.nlist)\n"
+        "  --attr NAME=VALUE   solver attribute (repeatable)\n"
+        "  --repeat N          export N times (default 1)\n"
+        "  --abort-after N     fail progress after N increments\n"
+        "  --verify            check the export file against the grid\n"
+        "  --quiet             only print errors and the summary line\n",
+        exe);
+}
+
+
+static bool
+parseUInt(const char *str, PWP_UINT32 &val)
+{
+    char *end = 0;
+    const unsigned long v = strtoul(str, &end, 10);
+    const bool ret = (end != str) && ('\0' == *end) && (v <= 0xffffffffUL);
+    if (ret) {
+        val = PWP_UINT32(v);
+    }
+    return ret;
+}
+
+
+static bool
+parseArgs(int argc, char *argv[], HarnessOptions &opts)
+{
+    bool ret = true;
+    for (int ii = 1; ret && ii < argc; ++ii) {
+        const std::string arg(argv[ii]);
+        const char *val = (ii + 1 < argc) ? argv[ii + 1] : 0;
+        if ("--verify" == arg) {
+            opts.verify = true;
+        }
+        else if ("--quiet" == arg) {
+            opts.quiet = true;
+        }
+        else if ("--no-bcs" == arg) {
+            opts.grid.useBCs = false;
+        }
+        else if ("--shuffle-faces" == arg) {
+            opts.grid.shuffleFaces = true;
+        }
+        else if (0 == val) {
+            ret = false;
+        }
+        else {
+            ++ii;
+            PWP_UINT32 n = 0;
+            if ("--nx" == arg) {
+                ret = parseUInt(val, opts.grid.nx);
+            }
+            else if ("--ny" == arg) {
+                ret = parseUInt(val, opts.grid.ny);
+            }
+            else if ("--nodes" == arg) {
+                ret = parseUInt(val, n) && (n >= 4);
+                if (ret) {
+                    opts.grid.nx = PWP_UINT32(std::sqrt(double(n)) + 0.5);
+                    opts.grid.ny = (n + opts.grid.nx - 1) / opts.grid.nx;
+                }
+            }
+            else if ("--elems" == arg) {
+                if (0 == strcmp(val, "tri")) {
+                    opts.grid.mix = MockElemTris;
+                }
+                else if (0 == strcmp(val, "quad")) {
+                    opts.grid.mix = MockElemQuads;
+                }
+                else if (0 == strcmp(val, "mixed")) {
+                    opts.grid.mix = MockElemMixed;
+                }
+                else {
+                    ret = false;
+                }
+            }
+            else if ("--elem-order" == arg) {
+                if (0 == strcmp(val, "blocks")) {
+                    opts.grid.order = MockOrderBlocks;
+                }
+                else if (0 == strcmp(val, "rows")) {
+                    opts.grid.order = MockOrderRows;
+                }
+                else {
+                    ret = false;
+                }
+            }
+            else if ("--coords" == arg) {
+                if (0 == strcmp(val, "jittered")) {
+                    opts.grid.coords = MockCoordsJittered;
+                }
+                else if (0 == strcmp(val, "ties")) {
+                    opts.grid.coords = MockCoordsTies;
+                }
+                else {
+                    ret = false;
+                }
+            }
+            else if ("--blocks" == arg) {
+                ret = parseUInt(val, opts.grid.blockCnt);
+            }
+            else if ("--materials" == arg) {
+                ret = parseUInt(val, opts.grid.materialCnt);
+            }
+            else if ("--format" == arg) {
+                if (0 == strcmp(val, "ascii")) {
+                    opts.encoding = PWP_ENCODING_ASCII;
+                }
+                else if (0 == strcmp(val, "binary")) {
+                    opts.encoding = PWP_ENCODING_BINARY;
+                }
+                else {
+                    ret = false;
+                }
+            }
+            else if ("--out" == arg) {
+                opts.outFile = val;
+            }
+            else if ("--attr" == arg) {
+                opts.attrs.push_back(val);
+            }
+            else if ("--repeat" == arg) {
+                ret = parseUInt(val, opts.repeat) && (opts.repeat > 0);
+            }
+            else if ("--abort-after" == arg) {
+                ret = parseUInt(val, opts.abortAfter);
+            }
+            else {
+                ret = false;
+            }
+        }
+        if (!ret) {
+            fprintf(stderr, "invalid argument: %s\n", arg.c_str());
+        }
+    }
+    return ret;
+}
+
+
+// Counts the lines of buf from pos up to the line that contains end (or the
+// end of buf)
+static size_t
+countLines(const std::string &buf, const size_t pos, const char *end)
+{
+    size_t stop = (0 == end) ? std::string::npos : buf.find(end, pos);
+    stop = (std::string::npos == stop) ? buf.size() :
+        buf.rfind('\n', stop) + 1;
+    size_t ret = 0;
+    for (size_t ii = pos; ii < stop; ++ii) {
+        ret += ('\n' == buf[ii]) ? 1 : 0;
+    }
+    return ret;
+}
+
+
+// Checks the section sizes of an ASCII export
+static bool
+verifyAscii(const HarnessOptions &opts, const MockGrid &grid,
+    const PWP_UINT32 faceCnt)
+{
+    std::string buf;
+    FILE *fp = fopen(opts.outFile.c_str(), "rb");
+    if (0 != fp) {
+        char tmp[65536];
+        size_t cnt;
+        while (0 != (cnt = fread(tmp, 1, sizeof(tmp), fp))) {
+            buf.append(tmp, cnt);
+        }
+        fclose(fp);
+    }
+    const size_t nodesAt = buf.find("***** NODES *****");
+    const size_t facesAt = buf.find("***** FACES *****");
+    const size_t geomAt = buf.find("***** GEOMETRY *****");
+    if (std::string::npos == nodesAt || std::string::npos == facesAt ||
+            std::string::npos == geomAt) {
+        fprintf(stderr, "verify: missing section in %s\n",
+            opts.outFile.c_str());
+        return false;
+    }
+    // the header count is at the start of each section line
+    const unsigned long nodeCnt = strtoul(buf.c_str() +
+        buf.rfind('\n', nodesAt) + 1, 0, 10);
+    const unsigned long hdrFaceCnt = strtoul(buf.c_str() +
+        buf.rfind('\n', facesAt) + 1, 0, 10);
+    const unsigned long geomCnt = strtoul(buf.c_str() +
+        buf.rfind('\n', geomAt) + 1, 0, 10);
+    const size_t nodeLines = countLines(buf, buf.find('\n', nodesAt) + 1,
+        "***** FACES *****");
+    const size_t faceLines = countLines(buf, buf.find('\n', facesAt) + 1,
+        "***** GEOMETRY *****");
+    const size_t geomLines = countLines(buf, buf.find('\n', geomAt) + 1, 0);
+    bool ret = true;
+    if (nodeCnt != grid.vertexCount() || nodeLines != 2 * nodeCnt) {
+        fprintf(stderr, "verify: NODES %lu (%lu lines), expected %lu\n",
+            nodeCnt, (unsigned long)nodeLines,
+            (unsigned long)grid.vertexCount());
+        ret = false;
+    }
+    if (hdrFaceCnt != faceCnt || faceLines != faceCnt) {
+        fprintf(stderr, "verify: FACES %lu (%lu lines), expected %lu\n",
+            hdrFaceCnt, (unsigned long)faceLines, (unsigned long)faceCnt);
+        ret = false;
+    }
+    if (geomLines != geomCnt) {
+        fprintf(stderr, "verify: GEOMETRY %lu (%lu lines)\n", geomCnt,
+            (unsigned long)geomLines);
+        ret = false;
+    }
+    return ret;
+}
+
+
+// Checks the sections of a binary export. Every grid edge must show up
+// once in the neighbors of each of its vertices.
+static bool
+verifyBinary(const HarnessOptions &opts, const MockGrid &grid,
+    const PWP_UINT32 faceCnt, const PWP_UINT32 edgeCnt)
+{
+    NlistBinaryReader rdr;
+    if (!rdr.read(opts.outFile.c_str())) {
+        fprintf(stderr, "verify: %s\n", rdr.error());
+        return false;
+    }
+    bool ret = true;
+    if (rdr.nodeCount() != grid.vertexCount()) {
+        fprintf(stderr, "verify: NODES %lu, expected %lu\n",
+            (unsigned long)rdr.nodeCount(), (unsigned long)grid.vertexCount());
+        ret = false;
+    }
+    if (rdr.faceCount() != faceCnt) {
+        fprintf(stderr, "verify: FACES %lu, expected %lu\n",
+            (unsigned long)rdr.faceCount(), (unsigned long)faceCnt);
+        ret = false;
+    }
+    PWP_UINT64 nborTotal = 0;
+    for (PWP_UINT32 ndx = 0; ret && ndx < rdr.nodeCount(); ++ndx) {
+        const PWP_UINT32 nborCnt = rdr.nborCount(ndx);
+        for (PWP_UINT32 ii = 0; ret && ii < nborCnt; ++ii) {
+            const PWP_UINT32 nbor = rdr.nbor(ndx, ii);
+            if (nbor >= rdr.nodeCount() || nbor == ndx) {
+                fprintf(stderr, "verify: node %lu has neighbor %lu\n",
+                    (unsigned long)ndx, (unsigned long)nbor);
+                ret = false;
+            }
+        }
+        nborTotal += nborCnt;
+    }
+    if (ret && nborTotal != 2 * PWP_UINT64(edgeCnt)) {
+        fprintf(stderr, "verify: %lu neighbors, expected %lu\n",
+            (unsigned long)nborTotal, 2 * (unsigned long)edgeCnt);
+        ret = false;
+    }
+    if (rdr.geometryCount() > edgeCnt) {
+        fprintf(stderr, "verify: GEOMETRY %lu exceeds %lu edges\n",
+            (unsigned long)rdr.geometryCount(), (unsigned long)edgeCnt);
+        ret = false;
+    }
+    return ret;
+}
+
+
+static PWP_UINT64
+fileBytes(const std::string &fileName)
+{
+    PWP_UINT64 ret = 0;
+    FILE *fp = fopen(fileName.c_str(), "rb");
+    if (0 != fp) {
+        if (0 == fseek(fp, 0, SEEK_END)) {
+            ret = PWP_UINT64(ftell(fp));
+        }
+        fclose(fp);
+    }
+    return ret;
+}
+
+
+static double
+fileMB(const std::string &fileName)
+{
+    return double(fileBytes(fileName)) / (1024.0 * 1024.0);
+}
+
+
+// Checks that the export file holds exactly what went through rtFile_. A
+// mapped binary export writes nothing through rtFile_, so rtFile_ must not
+// have had anything to flush over the mapped data.
+static bool
+verifyRtFile(const HarnessOptions &opts, const PWP_UINT64 rtBytes)
+{
+    const PWP_UINT64 bytes = fileBytes(opts.outFile);
+    const bool isMapped = (0 == rtBytes) &&
+        (PWP_ENCODING_BINARY == opts.encoding);
+    const bool ret = (rtBytes == bytes) || (isMapped && 0 != bytes);
+    if (!ret) {
+        fprintf(stderr, "verify: %lu bytes written through rtFile_, file has "
+            "%lu\n", (unsigned long)rtBytes, (unsigned long)bytes);
+    }
+    return ret;
+}
+
+
+// The plugin with access to the SDK-owned export file
+class HarnessPlugin : public CaeUnsUMCPSEG {
+public:
+    HarnessPlugin(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
+            const CAEP_WRITEINFO *pWriteInfo) :
+        CaeUnsUMCPSEG(pRti, model, pWriteInfo)
+    {
+    }
+
+    // The bytes written through rtFile_ by the last run()
+    PWP_UINT64  rtFileBytes() const {
+                    return rtFile_.bytesWritten(); }
+};
+
+
+int
+main(int argc, char *argv[])
+{
+    HarnessOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    MockGrid grid;
+    if (!grid.create(opts.grid)) {
+        fprintf(stderr, "invalid grid configuration\n");
+        return 2;
+    }
+    for (size_t ii = 0; ii < opts.attrs.size(); ++ii) {
+        if (!grid.setAttribute(opts.attrs[ii].c_str())) {
+            fprintf(stderr, "invalid attribute: %s\n", opts.attrs[ii].c_str());
+            return 2;
+        }
+    }
+    const double gridSec = std::chrono::duration<double>(Clock::now() -
+        t0).count();
+    const PWP_UINT32 faceCnt = grid.quadCount() * 2 + grid.triCount();
+    const PWP_UINT32 edgeCnt = (opts.grid.nx - 1) * opts.grid.ny +
+        opts.grid.nx * (opts.grid.ny - 1) + grid.triCount() / 2;
+    if (!opts.quiet) {
+        printf("grid: %lu x %lu vertices, %lu tris, %lu quads, %lu blocks, "
+            "%lu edges (%.3f sec)\n", (unsigned long)opts.grid.nx,
+            (unsigned long)opts.grid.ny, (unsigned long)grid.triCount(),
+            (unsigned long)grid.quadCount(), (unsigned long)grid.blockCount(),
+            (unsigned long)edgeCnt, gridSec);
+    }
+
+    CAEP_WRITEINFO writeInfo;
+    memset(&writeInfo, 0, sizeof(writeInfo));
+    writeInfo.fileDest = opts.outFile.c_str();
+    writeInfo.conditionsOnly = PWP_FALSE;
+    writeInfo.encoding = opts.encoding;
+    writeInfo.precision = PWP_PRECISION_DOUBLE;
+    writeInfo.dimension = PWP_DIMENSION_2D;
+
+    CAEP_RTITEM rti;
+    memset(&rti, 0, sizeof(rti));
+    rti.model = &grid;
+    rti.pWriteInfo = &writeInfo;
+    if (!CaeUnsUMCPSEG::create(rti)) {
+        fprintf(stderr, "CaeUnsUMCPSEG::create failed\n");
+        return 1;
+    }
+
+    bool ret = true;
+    double bestSec = 0.0;
+    PWP_UINT64 rtBytes = 0;
+    for (PWP_UINT32 run = 0; ret && run < opts.repeat; ++run) {
+        HarnessPlugin plugin(&rti, &grid, &writeInfo);
+        plugin.setAbortAfter(opts.abortAfter);
+        t0 = Clock::now();
+        ret = plugin.run() && (0 == plugin.errorCount());
+        const double sec = std::chrono::duration<double>(Clock::now() -
+            t0).count();
+        rtBytes = plugin.rtFileBytes();
+        bestSec = (0 == run || sec < bestSec) ? sec : bestSec;
+        if (!opts.quiet) {
+            const CaeProgressStepArray1 &steps = plugin.progressSteps();
+            printf("run %lu: %.3f sec, %lu of %lu major steps\n",
+                (unsigned long)run + 1, sec, (unsigned long)steps.size(),
+                (unsigned long)plugin.majorSteps());
+            for (size_t ii = 0; ii < steps.size(); ++ii) {
+                printf("  step %lu: %9.3f sec %7lu of %7lu increments\n",
+                    (unsigned long)ii + 1, steps[ii].seconds,
+                    (unsigned long)steps[ii].incrCnt,
+                    (unsigned long)steps[ii].total);
+            }
+        }
+    }
+    CaeUnsUMCPSEG::destroy(rti);
+
+    if (ret && opts.verify) {
+        ret = verifyRtFile(opts, rtBytes) &&
+            ((PWP_ENCODING_ASCII == opts.encoding) ?
+            verifyAscii(opts, grid, faceCnt) :
+            verifyBinary(opts, grid, faceCnt, edgeCnt));
+        if (ret && !opts.quiet) {
+            printf("verify: ok\n");
+        }
+    }
+
+    const double mb = fileMB(opts.outFile);
+    printf("%s: %lu nodes, %.1f MB, %.3f sec, %.0f nodes/s, %.1f MB/s\n",
+        ret ? "ok" : "FAILED", (unsigned long)grid.vertexCount(), mb, bestSec,
+        (bestSec > 0.0) ? grid.vertexCount() / bestSec : 0.0,
+        (bestSec > 0.0) ? mb / bestSec : 0.0);
+    return ret ? 0 : 1;
+}
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
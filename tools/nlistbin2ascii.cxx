@@ -0,0 +1,149 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * nlistbin2ascii
+ *
+ * Converts a binary .nlist file to the ASCII .nlist format. The output is
+ * byte identical to an ASCII export of the same grid (except for the time
+ * stamp in the header). Standalone tool, it does not need the PluginSDK:
+ *
+ *   c++ -O2 -I. tools/nlistbin2ascii.cxx -o nlistbin2ascii
+ *   nlistbin2ascii grid.nlist [ascii.nlist]
+ *
+ ***************************************************************************/
+
+#include "NlistBinary.h"
+#include "NlistFormat.h"
+
+#include<cstdio>
+#include<vector>
+
+
+// Max chars of one output line (excluding the NODES neighbor lines)
+enum { LineMaxChars = 128 };
+
+// Max chars per neighbor of a NODES line 2
+enum { NborMaxChars = 7 + NlistFormat::MaxIntChars };
+
+
+static bool
+writeLines(FILE *fp, const std::vector<char> &buf, const char *end)
+{
+    const size_t cnt = size_t(end - buf.data());
+    return cnt == fwrite(buf.data(), 1, cnt, fp);
+}
+
+
+static bool
+convert(const NlistBinaryReader &rdr, FILE *fp)
+{
+    std::vector<char> buf(LineMaxChars);
+    bool ret = (1 == fwrite(rdr.headerText(), rdr.headerBytes(), 1, fp)) ||
+        (0 == rdr.headerBytes());
+
+    // NODES - same as "%21.14E%21.14E%5d %2d %c %2d%2d\n" and "%7d" for each
+    // neighbor followed by "\n"
+    fprintf(fp, "%7d %5d          ***** NODES *****\n", int(rdr.nodeCount()),
+        int(rdr.nodeSubType()));
+    for (uint32_t ndx = 0; ret && ndx < rdr.nodeCount(); ++ndx) {
+        const uint32_t nborCnt = rdr.nborCount(ndx);
+        const size_t maxChars = LineMaxChars + size_t(nborCnt) * NborMaxChars;
+        if (buf.size() < maxChars) {
+            buf.resize(maxChars);
+        }
+        const int matId = int(rdr.matId(ndx));
+        char *p = buf.data();
+        p = NlistFormat::expField(p, rdr.x(ndx), 21, 14);
+        p = NlistFormat::expField(p, rdr.y(ndx), 21, 14);
+        p = NlistFormat::intField(p, int(nborCnt), 5);
+        *p++ = ' ';
+        p = NlistFormat::intField(p, matId, 2);
+        *p++ = ' ';
+        *p++ = NlistFormat::matIdChar(matId);
+        *p++ = ' ';
+        p = NlistFormat::intField(p, rdr.isBndry(ndx) ? 1 : 0, 2);
+        p = NlistFormat::intField(p, int(rdr.zoneId(ndx)), 2);
+        *p++ = '\n';
+        if (1 != nborCnt) {
+            // the exporter skips line 2 of an (invalid) one neighbor node
+            for (uint32_t ii = 0; ii < nborCnt; ++ii) {
+                p = NlistFormat::intField(p, int(rdr.nbor(ndx, ii) + 1), 7);
+            }
+            *p++ = '\n';
+        }
+        ret = writeLines(fp, buf, p);
+    }
+
+    // FACES - same as "%7d%7d%7d%7d\n" with the 3rd vertex repeated
+    fprintf(fp, "%7d        ***** FACES *****\n", int(rdr.faceCount()));
+    for (uint32_t ndx = 0; ret && ndx < rdr.faceCount(); ++ndx) {
+        char *p = buf.data();
+        p = NlistFormat::intField(p, int(rdr.faceVert(ndx, 0) + 1), 7);
+        p = NlistFormat::intField(p, int(rdr.faceVert(ndx, 1) + 1), 7);
+        p = NlistFormat::intField(p, int(rdr.faceVert(ndx, 2) + 1), 7);
+        p = NlistFormat::intField(p, int(rdr.faceVert(ndx, 2) + 1), 7);
+        *p++ = '\n';
+        ret = writeLines(fp, buf, p);
+    }
+
+    // GEOMETRY - same as "%13.5E%13.5E%13.5E%13.5E\n"
+    fprintf(fp, "%7d          ***** GEOMETRY *****\n",
+        int(rdr.geometryCount()));
+    for (uint32_t ndx = 0; ret && ndx < rdr.geometryCount(); ++ndx) {
+        char *p = buf.data();
+        for (uint32_t ii = 0; ii < 4; ++ii) {
+            p = NlistFormat::expField(p, rdr.geometry(ndx, ii), 13, 5);
+        }
+        *p++ = '\n';
+        ret = writeLines(fp, buf, p);
+    }
+    return ret && (0 == ferror(fp));
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s binary.nlist [ascii.nlist]\n", argv[0]);
+        return 2;
+    }
+    NlistBinaryReader rdr;
+    if (!rdr.read(argv[1])) {
+        fprintf(stderr, "%s: %s\n", argv[1], rdr.error());
+        return 1;
+    }
+    FILE *fp = (3 == argc) ? fopen(argv[2], "wb") : stdout;
+    if (0 == fp) {
+        fprintf(stderr, "%s: cannot open file\n", argv[2]);
+        return 1;
+    }
+    bool ret = convert(rdr, fp);
+    if (stdout != fp) {
+        ret = (0 == fclose(fp)) && ret;
+    }
+    if (!ret) {
+        fprintf(stderr, "write failed\n");
+    }
+    return ret ? 0 : 1;
+}
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * nlistlog2tcl
+ *
+ * Converts a binary log (LogFormat Binary) to the Tcl text log. The output
+ * is byte identical to a LogFormat Text log of the same export (except for
+ * the timings in the comments). Standalone tool, it does not need the
+ * PluginSDK:
+ *
+ *   c++ -O2 -I. tools/nlistlog2tcl.cxx -o nlistlog2tcl
+ *   nlistlog2tcl grid.nlist.log.bin [grid.nlist.log]
+ *
+ ***************************************************************************/
+
+#include "NlistLog.h"
+
+#include<cstdio>
+#include<vector>
+
+
+static bool
+writeLines(FILE *fp, const std::vector<char> &buf, const char *end)
+{
+    const size_t cnt = size_t(end - buf.data());
+    return cnt == fwrite(buf.data(), 1, cnt, fp);
+}
+
+
+static bool
+convert(NlistLogReader &rdr, FILE *fp)
+{
+    std::vector<char> buf(NlistLog::EdgeLineMaxChars);
+    uint32_t id;
+    const char *data;
+    uint32_t bytes;
+    bool ret = true;
+    while (ret && rdr.next(id, data, bytes)) {
+        NlistLog::NodeData node;
+        NlistLog::EdgeData edge;
+        switch (id) {
+        case NlistLog::Text:
+            ret = (bytes == fwrite(data, 1, bytes, fp));
+            break;
+        case NlistLog::Node:
+            ret = rdr.getNode(data, bytes, node);
+            if (ret) {
+                const size_t maxChars = NlistLog::nodeLineMaxChars(
+                    node.nborCnt);
+                if (buf.size() < maxChars) {
+                    buf.resize(maxChars);
+                }
+                ret = writeLines(fp, buf, NlistLog::formatNode(buf.data(),
+                    node.ndx, node.xyz, node.matId, node.zoneId, node.flags,
+                    node.nborCnt, node.nbors));
+            }
+            break;
+        case NlistLog::Edge:
+            ret = rdr.getEdge(data, bytes, edge) &&
+                writeLines(fp, buf, NlistLog::formatEdge(buf.data(),
+                    edge.ndx0, edge.xyz0, edge.ndx1, edge.xyz1));
+            break;
+        default:
+            // unknown records are skipped
+            break;
+        }
+    }
+    return ret && ('\0' == *rdr.error()) && (0 == ferror(fp));
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s log.bin [log.tcl]\n", argv[0]);
+        return 2;
+    }
+    NlistLogReader rdr;
+    if (!rdr.read(argv[1])) {
+        fprintf(stderr, "%s: %s\n", argv[1], rdr.error());
+        return 1;
+    }
+    FILE *fp = (3 == argc) ? fopen(argv[2], "wb") : stdout;
+    if (0 == fp) {
+        fprintf(stderr, "%s: cannot open file\n", argv[2]);
+        return 1;
+    }
+    bool ret = convert(rdr, fp);
+    if (stdout != fp) {
+        ret = (0 == fclose(fp)) && ret;
+    }
+    if (!ret) {
+        fprintf(stderr, "%s: %s\n", argv[1], ('\0' == *rdr.error()) ?
+            "write failed" : rdr.error());
+    }
+    return ret ? 0 : 1;
+}
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/